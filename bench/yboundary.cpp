@@ -0,0 +1,492 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+/*
+ * Microbenchmarks of the host <-> Lua boundary: calls, marshalling of every variant type, callbacks,
+ * path walking, and raw Lua C API baselines for the same work.
+ * 
+ * Usage: yboundary [--filter <substring>] [--min-time <ms>] [--repetitions <n>] [--format json|csv] [--out <file>]
+ * Results go to stdout (or --out) as JSON or CSV, one record per case, to be compared between versions.
+ */
+
+#include "inc/lua/lua.hpp"
+#include "inc/yumem.hpp"
+#include "inc/types/state.hpp"
+#include "inc/types/variant.h"
+#include "inc/sdk/lsdk.hpp"
+#include "inc/sdk/lframe.hpp"
+#include "inc/types/containers/string.hpp"
+#include "inc/version/engine_version.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+
+using namespace YumEngine::xV1;
+
+namespace {
+  using bench_clock = std::chrono::steady_clock;
+
+  struct options {
+    std::string filter;
+    double      min_time_ms = 200;
+    int         repetitions = 5;
+    bool        csv = false;
+    std::string out;
+  };
+
+  /** @brief Measured case. Times are per operation. */
+  struct result {
+    std::string name;
+    uint64_t    iterations;  // Per repetition.
+    uint64_t    bytes;       // Payload per operation, 0 when not relevant.
+    double      median_ns;
+    double      min_ns;
+    double      max_ns;
+  };
+
+  /** @brief Runs `body(n)`, doing n operations, until a repetition lasts `min_time_ms`. Then measures repetitions of it. */
+  class runner {
+  private:
+    const options       &opts;
+    std::vector<result>  results;
+
+    static double run_ns(const std::function<void(uint64_t)> &body, uint64_t n) {
+      bench_clock::time_point start = bench_clock::now();
+      body(n);
+      return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count();
+    }
+
+  public:
+    inline runner(const options &opts) : opts(opts) {}
+
+    void add(const std::string &name, uint64_t bytes, const std::function<void(uint64_t)> &body) {
+      if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos) return;
+
+      double target_ns = opts.min_time_ms * 1e6;
+      uint64_t n = 1;
+      double ns = run_ns(body, n);
+
+      while (ns < target_ns / 10 && n < ((uint64_t)1 << 40)) {
+        n *= 10;
+        ns = run_ns(body, n);
+      }
+
+      n = std::max<uint64_t>(1, (uint64_t)((double)n * target_ns / std::max(ns, 1.0)));
+
+      std::vector<double> samples;
+      for (int i = 0; i < opts.repetitions; i++) samples.push_back(run_ns(body, n) / (double)n);
+      std::sort(samples.begin(), samples.end());
+
+      results.push_back(result{ 
+        .name = name, .iterations = n, .bytes = bytes,
+        .median_ns = samples[samples.size() / 2], .min_ns = samples.front(), .max_ns = samples.back() 
+      });
+
+      std::fprintf(stderr, "%-48s %12.1f ns/op\n", name.c_str(), results.back().median_ns);
+    }
+
+    void write(FILE *out) const {
+      if (opts.csv) {
+        std::fprintf(out, "name,iterations,bytes,median_ns,min_ns,max_ns,mb_per_s\n");
+        for (const result &r : results) {
+          std::fprintf(out, "%s,%llu,%llu,%.3f,%.3f,%.3f,%.3f\n", r.name.c_str(), (unsigned long long)r.iterations, 
+            (unsigned long long)r.bytes, r.median_ns, r.min_ns, r.max_ns, r.bytes ? (double)r.bytes * 1e3 / r.median_ns : 0.0);
+        }
+        return;
+      }
+
+      std::fprintf(out, "{\n  \"suite\": \"yboundary\",\n  \"engine\": \"%d.%d.%d\",\n  \"lua\": \"%s\",\n", 
+        YUM_ENGINE_VERSION_MAJOR, YUM_ENGINE_VERSION_MINOR, YUM_ENGINE_VERSION_PATCH, LUA_RELEASE);
+      std::fprintf(out, "  \"compiler\": \"%s\",\n  \"min_time_ms\": %.1f,\n  \"repetitions\": %d,\n  \"results\": [\n", 
+        __VERSION__, opts.min_time_ms, opts.repetitions);
+
+      for (size_t i = 0; i < results.size(); i++) {
+        const result &r = results[i];
+        std::fprintf(out, "    { \"name\": \"%s\", \"iterations\": %llu, \"bytes\": %llu, \"median_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f }%s\n",
+          r.name.c_str(), (unsigned long long)r.iterations, (unsigned long long)r.bytes, r.median_ns, r.min_ns, r.max_ns,
+          i + 1 < results.size() ? "," : "");
+      }
+
+      std::fprintf(out, "  ]\n}\n");
+    }
+  };
+
+  /** @brief Keeps the compiler from removing the work of a loop. */
+  template <typename T>
+  inline void keep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+  }
+
+  const char *const script = R"lua(
+    bench = { nested = { deeper = { } } }
+
+    function bench.f0() end
+    function bench.f1(a) return a end
+    function bench.f8(a, b, c, d, e, f, g, h) return a end
+    function bench.id(x) return x end
+    function bench.nested.deeper.f1(a) return a end
+
+    function bench.callbacks(n)
+      local cb = host.cb
+      for i = 1, n do cb(i) end
+    end
+
+    function bench.lua_calls(n)
+      local f = function(x) return x end
+      for i = 1, n do f(i) end
+    end
+  )lua";
+
+  variant_t integer(integer_t value) {
+    return variant_t{ .hold = { .integer = value }, .type = variant_t::VARIANT_INTEGER };
+  }
+
+  void check(const syserr_t &err, const char *what) {
+    if (err.category == syserr_t::OK) return;
+    std::fprintf(stderr, "%s failed: %.*s\n", what, (int)err.comment.length, err.comment.start);
+    std::exit(1);
+  }
+
+  /** @brief Frees the values returned by State::call. */
+  void free_results(uint64_t count, variant_t *values) {
+    for (uint64_t i = 0; i < count; i++) {
+      variant_t &v = values[i];
+      if (v.type == variant_t::VARIANT_STRING && v.hold.lstring.owns) yumfree((void*)v.hold.lstring.start);
+      else if (v.type == variant_t::VARIANT_BINARY && v.hold.binary.owns) yumfree((void*)v.hold.binary.start);
+      else if (v.type == variant_t::VARIANT_TABLE) yumfree_table(v.hold.table);
+      else if (v.type == variant_t::VARIANT_INTEGER_ARRAY && v.hold.integers.owns) yumfree((void*)v.hold.integers.start);
+      else if (v.type == variant_t::VARIANT_NUMBER_ARRAY && v.hold.numbers.owns) yumfree((void*)v.hold.numbers.start);
+    }
+    if (count) yumfree((void*)values);
+  }
+
+  variant_t *classic_callback(uint64_t, const variant_t*, uint64_t *outc) {
+    *outc = 0;
+    return nullptr;
+  }
+
+  variant_t *context_callback(void *, uint64_t, const variant_t*, uint64_t *outc) {
+    *outc = 0;
+    return nullptr;
+  }
+
+  boolean_t fast_callback(void *, uint64_t, const variant_t*, varframe_t *out) {
+    out->count = 0;
+    return true;
+  }
+
+  int raw_callback(lua_State *) {
+    return 0;
+  }
+
+  void bench_raw_lua(runner &run) {
+    lua_State *L = luaL_newstate();
+    luaL_openlibs(L);
+    lua_pushcfunction(L, raw_callback);
+    lua_setglobal(L, "cb");
+    if (luaL_dostring(L, script) != LUA_OK) {
+      std::fprintf(stderr, "raw script failed: %s\n", lua_tostring(L, -1));
+      std::exit(1);
+    }
+    lua_newtable(L);
+    lua_pushcfunction(L, raw_callback);
+    lua_setfield(L, -2, "cb");
+    lua_setglobal(L, "host");
+
+    for (int argc : { 0, 1, 8 }) {
+      const char *name = argc == 0 ? "f0" : argc == 1 ? "f1" : "f8";
+      run.add("lua_capi/call/" + std::to_string(argc) + "args", 0, [L, argc, name](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+          lua_getglobal(L, "bench");
+          lua_getfield(L, -1, name);
+          for (int a = 0; a < argc; a++) lua_pushinteger(L, (lua_Integer)i);
+          lua_pcall(L, argc, LUA_MULTRET, 0);
+          lua_settop(L, 0);
+        }
+      });
+    }
+
+    for (size_t size : { (size_t)8, (size_t)1024, (size_t)1 << 20 }) {
+      std::string payload(size, 'x');
+      run.add("lua_capi/string/" + std::to_string(size), size, [L, payload](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+          lua_getglobal(L, "bench");
+          lua_getfield(L, -1, "id");
+          lua_pushlstring(L, payload.data(), payload.size());
+          lua_pcall(L, 1, 1, 0);
+          size_t length = 0;
+          keep(lua_tolstring(L, -1, &length));
+          lua_settop(L, 0);
+        }
+      });
+    }
+
+    run.add("lua_capi/callback", 0, [L](uint64_t n) {
+      lua_getglobal(L, "bench");
+      lua_getfield(L, -1, "callbacks");
+      lua_pushinteger(L, (lua_Integer)n);
+      lua_pcall(L, 1, 0, 0);
+      lua_settop(L, 0);
+    });
+
+    run.add("lua_capi/lua_to_lua_call", 0, [L](uint64_t n) {
+      lua_getglobal(L, "bench");
+      lua_getfield(L, -1, "lua_calls");
+      lua_pushinteger(L, (lua_Integer)n);
+      lua_pcall(L, 1, 0, 0);
+      lua_settop(L, 0);
+    });
+
+    lua_close(L);
+  }
+
+  void bench_calls(runner &run, State &state) {
+    for (uint64_t argc : { 0, 1, 8 }) {
+      std::string path = argc == 0 ? "bench.f0" : argc == 1 ? "bench.f1" : "bench.f8";
+      std::vector<variant_t> args(argc, integer(42));
+      std::string suffix = std::to_string(argc) + "args";
+
+      run.add("state_call/path/" + suffix, 0, [&state, path, args](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+          uint64_t nargs = 0;
+          variant_t *out = nullptr;
+          check(state.call(path.c_str(), path.size(), args.size(), args.data(), nargs, &out), "call");
+          free_results(nargs, out);
+        }
+      });
+
+      run.add("state_call/frame/" + suffix, 0, [&state, path, args](uint64_t n) {
+        Sdk::Frame frame;
+        for (uint64_t i = 0; i < n; i++) check(state.call(path.c_str(), path.size(), args.size(), args.data(), frame.c()), "call");
+      });
+
+      fnhandle_t handle;
+      check(state.resolve(path.c_str(), path.size(), handle), "resolve");
+      run.add("state_call/handle/" + suffix, 0, [&state, handle, args](uint64_t n) {
+        Sdk::Frame frame;
+        for (uint64_t i = 0; i < n; i++) check(state.call(handle, args.size(), args.data(), frame.c()), "call");
+      });
+      state.release(handle);
+    }
+
+    std::string deep = "bench.nested.deeper.f1";
+    variant_t arg = integer(42);
+    run.add("state_call/frame/deep_path", 0, [&state, deep, arg](uint64_t n) {
+      Sdk::Frame frame;
+      for (uint64_t i = 0; i < n; i++) check(state.call(deep.c_str(), deep.size(), 1, &arg, frame.c()), "call");
+    });
+
+    run.add("state_call/batch_item/1args", 0, [&state](uint64_t n) {
+      constexpr uint64_t chunk = 256;
+      std::vector<variant_t> args(chunk, integer(42)), out(chunk);
+      uint64_t nfailed = 0;
+      for (uint64_t done = 0; done < n; done += chunk) {
+        uint64_t count = std::min(chunk, n - done);
+        check(state.call_batch("bench.f1", 8, count, 1, args.data(), 1, out.data(), nullptr, nfailed), "call_batch");
+      }
+    });
+  }
+
+  /** @brief Round-trips one value through `bench.id`: host to Lua, then back. */
+  void bench_marshal(runner &run, State &state, const std::string &name, const variant_t &value, uint64_t bytes) {
+    run.add("marshal/" + name, bytes, [&state, value](uint64_t n) {
+      Sdk::Frame frame(1, 256);
+      for (uint64_t i = 0; i < n; i++) {
+        syserr_t err = state.call("bench.id", 8, 1, &value, frame.c());
+        if (err.category == syserr_t::BUFFER_OVERFLOW) {
+          frame.reserve(frame.c().count, frame.c().arena_used);
+          err = state.call("bench.id", 8, 1, &value, frame.c());
+        }
+        check(err, "call");
+      }
+    });
+
+    run.add("push_variant/" + name, bytes, [&state, value](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) {
+        state.push_global("bench");
+        state.push_variant("value", value);
+      }
+    });
+  }
+
+  void bench_types(runner &run, State &state) {
+    bench_marshal(run, state, "nil", variant_t{ .hold = { .nil = {} }, .type = variant_t::VARIANT_NIL }, 0);
+    bench_marshal(run, state, "bool", variant_t{ .hold = { .boolean = true }, .type = variant_t::VARIANT_BOOL }, 0);
+    bench_marshal(run, state, "integer", integer(42), 0);
+    bench_marshal(run, state, "number", variant_t{ .hold = { .number = 4.2 }, .type = variant_t::VARIANT_NUMBER }, 0);
+    bench_marshal(run, state, "uid", variant_t{ .hold = { .uid = {} }, .type = variant_t::VARIANT_UID }, 0);
+
+    // Reserved: moving short strings would move their characters.
+    static std::vector<std::string> strings;
+    strings.reserve(16);
+    for (size_t size = 8; size <= ((size_t)1 << 20); size *= 8) {
+      strings.emplace_back(size, 'x');
+      const std::string &s = strings.back();
+      variant_t value{ .hold = { .lstring = { .start = s.data(), .length = s.size(), .owns = false } }, .type = variant_t::VARIANT_STRING };
+      bench_marshal(run, state, "string/" + std::to_string(size), value, size);
+    }
+
+    strings.emplace_back((size_t)1 << 20, 'x');
+    const std::string &mb = strings.back();
+    bench_marshal(run, state, "string/1048576", 
+      variant_t{ .hold = { .lstring = { .start = mb.data(), .length = mb.size(), .owns = false } }, .type = variant_t::VARIANT_STRING }, mb.size());
+
+    static std::vector<uint8_t> bytes(4096, 7);
+    bench_marshal(run, state, "binary/4096", 
+      variant_t{ .hold = { .binary = { .start = bytes.data(), .length = bytes.size(), .owns = false } }, .type = variant_t::VARIANT_BINARY }, bytes.size());
+
+    static std::vector<integer_t> integers(64, 42);
+    bench_marshal(run, state, "integer_array/64", 
+      variant_t{ .hold = { .integers = { .start = integers.data(), .length = integers.size(), .owns = false } }, .type = variant_t::VARIANT_INTEGER_ARRAY }, 
+      integers.size() * sizeof(integer_t));
+
+    static std::vector<number_t> numbers(64, 4.2);
+    bench_marshal(run, state, "number_array/64", 
+      variant_t{ .hold = { .numbers = { .start = numbers.data(), .length = numbers.size(), .owns = false } }, .type = variant_t::VARIANT_NUMBER_ARRAY }, 
+      numbers.size() * sizeof(number_t));
+
+    static std::vector<variant_t> values(8, integer(42));
+    static vartable_t table{ .keys = nullptr, .values = values.data(), .length = values.size(), .owns = false };
+    bench_marshal(run, state, "table/8", variant_t{ .hold = { .table = &table }, .type = variant_t::VARIANT_TABLE }, 0);
+  }
+
+  void bench_callbacks(runner &run) {
+    struct kind {
+      const char *name;
+      std::function<void(State&)> push;
+    };
+
+    const kind kinds[] = {
+      { "classic", [](State &s) { s.push_callback("cb", classic_callback); } },
+      { "context", [](State &s) { s.push_callback("cb", context_callback, nullptr); } },
+      { "fast",    [](State &s) { s.push_callback("cb", fast_callback, nullptr); } },
+    };
+
+    for (const kind &k : kinds) {
+      State state;
+      state.open_stdlibs();
+      check(state.run("host = {}", false), "run");
+      state.clear();
+      state.push_global("host");
+      k.push(state);
+      state.clear();
+      check(state.run(script, false), "run");
+      state.clear();
+
+      run.add(std::string("callback/") + k.name, 0, [&state](uint64_t n) {
+        variant_t count = integer((integer_t)n);
+        Sdk::Frame frame;
+        check(state.call("bench.callbacks", 15, 1, &count, frame.c()), "call");
+      });
+    }
+  }
+
+  void bench_sdk(runner &run) {
+    Sdk::SdkState sdk;
+    sdk.open_libs();
+    sdk.run(script);
+
+    CVariant arg((integer_t)42);
+    Sdk::Buffer<CVariant> args(&arg, 1);
+
+    run.add("sdk_call/list/1args", 0, [&sdk, &args](uint64_t n) {
+      for (uint64_t i = 0; i < n; i++) keep(sdk.call("bench.f1", args));
+    });
+
+    run.add("sdk_call/frame/1args", 0, [&sdk, &args](uint64_t n) {
+      Sdk::Frame frame;
+      for (uint64_t i = 0; i < n; i++) sdk.call("bench.f1", args, frame);
+    });
+  }
+
+  void bench_paths(runner &run) {
+    for (const char *path : { "f", "bench.f1", "bench.nested.deeper.f1" }) {
+      Sdk::strview view(path, std::strlen(path));
+      run.add(std::string("path_split/") + path, 0, [view](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) keep(view.split('.'));
+      });
+    }
+  }
+
+  bool parse(int argc, char **argv, options &opts) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+
+      if (arg == "--filter" && has_value) opts.filter = argv[++i];
+      else if (arg == "--min-time" && has_value) opts.min_time_ms = std::atof(argv[++i]);
+      else if (arg == "--repetitions" && has_value) opts.repetitions = std::max(1, std::atoi(argv[++i]));
+      else if (arg == "--format" && has_value) opts.csv = std::string(argv[++i]) == "csv";
+      else if (arg == "--out" && has_value) opts.out = argv[++i];
+      else return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char **argv) {
+  options opts;
+  if (!parse(argc, argv, opts)) {
+    std::fprintf(stderr, "usage: %s [--filter <substring>] [--min-time <ms>] [--repetitions <n>] [--format json|csv] [--out <file>]\n", argv[0]);
+    return 2;
+  }
+
+  runner run(opts);
+
+  bench_raw_lua(run);
+
+  {
+    State state;
+    state.open_stdlibs();
+    check(state.run("host = {}", false), "run");
+    state.clear();
+    state.push_global("host");
+    state.push_callback("cb", fast_callback, nullptr);
+    state.clear();
+    check(state.run(script, false), "run");
+    state.clear();
+
+    bench_calls(run, state);
+    bench_types(run, state);
+  }
+
+  bench_callbacks(run);
+  bench_sdk(run);
+  bench_paths(run);
+
+  FILE *out = opts.out.empty() ? stdout : std::fopen(opts.out.c_str(), "w");
+  if (!out) {
+    std::fprintf(stderr, "cannot open %s\n", opts.out.c_str());
+    return 1;
+  }
+
+  run.write(out);
+  if (out != stdout) std::fclose(out);
+  return 0;
+}
@@ -0,0 +1,421 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+/*
+ * Load generator: N States driven by T threads with a mix of calls, callbacks and pushes, for contention
+ * and memory behaviour under load. Reports throughput, latency percentiles and RSS every interval.
+ * 
+ * Usage: yloadtest [--states N] [--threads T] [--duration <s>] [--interval <ms>] [--work <iterations>]
+ *                  [--mix call=70,callback=20,push=10] [--script <file>] [--shared] [--pooled] [--engine-stats] [--hw-counters]
+ *                  [--format text|json]
+ * 
+ * Scripts define `work.call(n)` and `work.callback(n)`, the latter calling `host.tick` n times.
+ * By default, each thread owns States (i % T). With --shared, threads lock random States instead.
+ * --pooled gives every State the size-class allocator, --engine-stats records the engine's own call stats.
+ * --hw-counters adds hardware counters to them (Linux): IPC, and cache and branch misses per call.
+ * JSON output is one object per line: one per interval, then the summary.
+ */
+
+#include "inc/types/state.hpp"
+#include "inc/types/callstats.hpp"
+#include "inc/sdk/lframe.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <unistd.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace YumEngine::xV1;
+
+namespace {
+  using load_clock = std::chrono::steady_clock;
+
+  enum op_t { OP_CALL, OP_CALLBACK, OP_PUSH, OP_COUNT };
+  const char *const op_names[OP_COUNT] = { "call", "callback", "push" };
+
+  struct options {
+    uint64_t    states = 8;
+    uint64_t    threads = 4;
+    double      duration_s = 10;
+    uint64_t    interval_ms = 1000;
+    uint64_t    work = 100;
+    uint32_t    mix[OP_COUNT] = { 70, 20, 10 };
+    std::string script;
+    bool        shared = false;
+    bool        pooled = false;
+    bool        engine_stats = false;
+    bool        hw_counters = false;
+    bool        json = false;
+  };
+
+  const char *const default_script = R"lua(
+    work = {}
+
+    function work.call(n)
+      local t = {}
+      for i = 1, n do t[i] = i * 2 end
+      return #t
+    end
+
+    function work.callback(n)
+      local tick = host.tick
+      for i = 1, n do tick(i) end
+    end
+  )lua";
+
+  struct driven_state {
+    State      state;
+    std::mutex lock; // Taken in shared mode only.
+
+    driven_state() = default;
+    explicit driven_state(const allocpolicy_t &policy) : state(policy) {}
+  };
+
+  boolean_t tick(void *, uint64_t, const variant_t*, varframe_t *out) {
+    out->count = 0;
+    return true;
+  }
+
+  uint64_t rss_bytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#else
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_maxrss; // Peak, in bytes on macOS.
+#endif
+  }
+
+  bool parse_mix(const std::string &text, uint32_t (&mix)[OP_COUNT]) {
+    std::fill(std::begin(mix), std::end(mix), 0);
+    std::stringstream items(text);
+    std::string item;
+
+    while (std::getline(items, item, ',')) {
+      size_t eq = item.find('=');
+      if (eq == std::string::npos) return false;
+
+      std::string name = item.substr(0, eq);
+      auto it = std::find_if(std::begin(op_names), std::end(op_names), [&](const char *n) { return name == n; });
+      if (it == std::end(op_names)) return false;
+      mix[it - std::begin(op_names)] = (uint32_t)std::atoi(item.c_str() + eq + 1);
+    }
+
+    return mix[OP_CALL] + mix[OP_CALLBACK] + mix[OP_PUSH] > 0;
+  }
+
+  bool parse(int argc, char **argv, options &opts) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+
+      if (arg == "--states" && has_value) opts.states = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+      else if (arg == "--threads" && has_value) opts.threads = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+      else if (arg == "--duration" && has_value) opts.duration_s = std::atof(argv[++i]);
+      else if (arg == "--interval" && has_value) opts.interval_ms = std::max<uint64_t>(10, std::strtoull(argv[++i], nullptr, 10));
+      else if (arg == "--work" && has_value) opts.work = std::strtoull(argv[++i], nullptr, 10);
+      else if (arg == "--mix" && has_value) { if (!parse_mix(argv[++i], opts.mix)) return false; }
+      else if (arg == "--script" && has_value) opts.script = argv[++i];
+      else if (arg == "--shared") opts.shared = true;
+      else if (arg == "--pooled") opts.pooled = true;
+      else if (arg == "--engine-stats") opts.engine_stats = true;
+      else if (arg == "--hw-counters") opts.engine_stats = opts.hw_counters = true;
+      else if (arg == "--format" && has_value) opts.json = std::string(argv[++i]) == "json";
+      else return false;
+    }
+    return true;
+  }
+
+  /** @brief Latencies of the operations of an interval: the difference of two snapshots. */
+  struct interval {
+    uint64_t ops[OP_COUNT] = {};
+    uint64_t errors[OP_COUNT] = {};
+    uint64_t p50[OP_COUNT] = {};
+    uint64_t p99[OP_COUNT] = {};
+    uint64_t p999[OP_COUNT] = {};
+  };
+
+  interval difference(const std::vector<CallStats::entry> &now, const std::vector<CallStats::entry> &before) {
+    interval result;
+
+    for (const CallStats::entry &e : now) {
+      auto it = std::find(std::begin(op_names), std::end(op_names), e.name);
+      if (it == std::end(op_names)) continue;
+      int op = (int)(it - std::begin(op_names));
+
+      CallStats::entry delta = e;
+      delta.max_ns = UINT64_MAX; // Unknown for the interval: percentiles stay at bucket limits.
+      for (const CallStats::entry &b : before) {
+        if (b.name != e.name) continue;
+        delta.calls -= b.calls;
+        delta.errors -= b.errors;
+        for (size_t i = 0; i < delta.histogram.size(); i++) delta.histogram[i] -= std::min(delta.histogram[i], b.histogram[i]);
+      }
+
+      result.ops[op] = delta.calls;
+      result.errors[op] = delta.errors;
+      result.p50[op] = delta.percentile(0.5);
+      result.p99[op] = delta.percentile(0.99);
+      result.p999[op] = delta.percentile(0.999);
+    }
+
+    return result;
+  }
+
+  void report(const options &opts, double elapsed_s, double seconds, const interval &iv, uint64_t rss) {
+    uint64_t total = iv.ops[OP_CALL] + iv.ops[OP_CALLBACK] + iv.ops[OP_PUSH];
+
+    if (opts.json) {
+      std::printf("{\"t\":%.3f,\"ops_per_s\":%.1f,\"rss_bytes\":%llu", elapsed_s, (double)total / seconds, (unsigned long long)rss);
+      for (int op = 0; op < OP_COUNT; op++) {
+        std::printf(",\"%s\":{\"ops\":%llu,\"errors\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu}", op_names[op], 
+          (unsigned long long)iv.ops[op], (unsigned long long)iv.errors[op], (unsigned long long)iv.p50[op], 
+          (unsigned long long)iv.p99[op], (unsigned long long)iv.p999[op]);
+      }
+      std::printf("}\n");
+    } else {
+      std::printf("%8.1fs %12.0f ops/s  rss %8.1f MiB", elapsed_s, (double)total / seconds, (double)rss / (1024.0 * 1024.0));
+      for (int op = 0; op < OP_COUNT; op++) {
+        if (!iv.ops[op]) continue;
+        std::printf("  | %s p50 %.1fus p99 %.1fus p99.9 %.1fus", op_names[op], 
+          (double)iv.p50[op] / 1e3, (double)iv.p99[op] / 1e3, (double)iv.p999[op] / 1e3);
+      }
+      std::printf("\n");
+    }
+
+    std::fflush(stdout);
+  }
+
+  void drive(const options &opts, std::vector<std::unique_ptr<driven_state>> &states, uint64_t index, 
+             CallStats &latencies, const std::atomic<bool> &stop) {
+    std::mt19937_64 random(index * 7919 + 1);
+    uint32_t mix_total = opts.mix[OP_CALL] + opts.mix[OP_CALLBACK] + opts.mix[OP_PUSH];
+
+    std::vector<driven_state*> owned;
+    for (uint64_t i = index; i < states.size(); i += opts.threads) owned.push_back(states[i].get());
+    if (!opts.shared && owned.empty()) return;
+
+    Sdk::Frame frame;
+    std::string payload(64, 'x');
+    variant_t work{ .hold = { .integer = (integer_t)opts.work }, .type = variant_t::VARIANT_INTEGER };
+    variant_t value{ .hold = { .lstring = { .start = payload.data(), .length = payload.size(), .owns = false } }, .type = variant_t::VARIANT_STRING };
+
+    for (uint64_t n = 0; !stop.load(std::memory_order_relaxed); n++) {
+      uint32_t pick = (uint32_t)(random() % mix_total);
+      op_t op = pick < opts.mix[OP_CALL] ? OP_CALL : pick < opts.mix[OP_CALL] + opts.mix[OP_CALLBACK] ? OP_CALLBACK : OP_PUSH;
+
+      driven_state &target = opts.shared ? *states[random() % states.size()] : *owned[n % owned.size()];
+      load_clock::time_point start = load_clock::now();
+
+      // Waiting for a shared State counts in the latency: that is the contention being measured.
+      std::unique_lock<std::mutex> guard(target.lock, std::defer_lock);
+      if (opts.shared) guard.lock();
+
+      bool failed = false;
+      switch (op) {
+        case OP_CALL:
+          failed = target.state.call("work.call", 9, 1, &work, frame.c()).category != syserr_t::OK;
+          break;
+        case OP_CALLBACK:
+          failed = target.state.call("work.callback", 13, 1, &work, frame.c()).category != syserr_t::OK;
+          break;
+        default:
+          target.state.push_global("work");
+          target.state.push_variant("value", value);
+          break;
+      }
+
+      if (guard.owns_lock()) guard.unlock();
+      uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(load_clock::now() - start).count();
+      latencies.record(CallStats::LUA_PATH, op_names[op], failed, 0, ns);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  options opts;
+  if (!parse(argc, argv, opts)) {
+    std::fprintf(stderr, 
+      "usage: %s [--states N] [--threads T] [--duration <s>] [--interval <ms>] [--work <iterations>]\n"
+      "          [--mix call=70,callback=20,push=10] [--script <file>] [--shared] [--pooled] [--engine-stats] [--hw-counters]\n"
+      "          [--format text|json]\n", argv[0]);
+    return 2;
+  }
+
+  std::string script = default_script;
+  if (!opts.script.empty()) {
+    std::ifstream file(opts.script, std::ios::binary);
+    if (!file) {
+      std::fprintf(stderr, "cannot read %s\n", opts.script.c_str());
+      return 1;
+    }
+    script.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  uint64_t rss_before = rss_bytes();
+  std::shared_ptr<CallStats> engine_stats = opts.engine_stats ? std::make_shared<CallStats>() : nullptr;
+  if (opts.hw_counters) {
+    engine_stats->count_hardware(true);
+    if (!PerfCounters::available()) std::fprintf(stderr, "warning: hardware counters are not available, see perf_event_paranoid\n");
+  }
+
+  std::vector<std::unique_ptr<driven_state>> states;
+  for (uint64_t i = 0; i < opts.states; i++) {
+    states.push_back(opts.pooled 
+      ? std::make_unique<driven_state>(allocpolicy_t{ .alloc = nullptr, .userdata = nullptr, .pooled = true, .limit = 0 })
+      : std::make_unique<driven_state>());
+    State &state = states.back()->state;
+
+    state.open_stdlibs();
+    syserr_t err = state.run("host = {}", false);
+    state.clear();
+    state.push_global("host");
+    state.push_callback("tick", tick, nullptr);
+    state.clear();
+    if (err.category == syserr_t::OK) err = state.run(script.c_str(), false);
+    state.clear();
+
+    if (err.category != syserr_t::OK) {
+      std::fprintf(stderr, "script failed: %.*s\n", (int)err.comment.length, err.comment.start);
+      return 1;
+    }
+
+    state.use_call_stats(engine_stats);
+  }
+
+  uint64_t rss_loaded = rss_bytes();
+  if (!opts.json) {
+    std::printf("%llu states, %llu threads (%s%s), rss %.1f MiB -> %.1f MiB after loading\n", 
+      (unsigned long long)opts.states, (unsigned long long)opts.threads, opts.shared ? "shared" : "owned", opts.pooled ? ", pooled" : "",
+      (double)rss_before / (1024.0 * 1024.0), (double)rss_loaded / (1024.0 * 1024.0));
+  }
+
+  CallStats latencies;
+  std::atomic<bool> stop = false;
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < opts.threads; t++) {
+    threads.emplace_back([&, t] { drive(opts, states, t, latencies, stop); });
+  }
+
+  load_clock::time_point started = load_clock::now();
+  load_clock::time_point last = started;
+  std::vector<CallStats::entry> previous;
+
+  for (;;) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(opts.interval_ms));
+
+    load_clock::time_point now = load_clock::now();
+    double elapsed = std::chrono::duration<double>(now - started).count();
+    double seconds = std::chrono::duration<double>(now - last).count();
+    last = now;
+
+    std::vector<CallStats::entry> current = latencies.snapshot();
+    report(opts, elapsed, seconds, difference(current, previous), rss_bytes());
+    previous = std::move(current);
+
+    if (elapsed >= opts.duration_s) break;
+  }
+
+  stop.store(true);
+  for (std::thread &thread : threads) thread.join();
+
+  double elapsed = std::chrono::duration<double>(load_clock::now() - started).count();
+  interval total = difference(latencies.snapshot(), {});
+  uint64_t rss_end = rss_bytes();
+
+  if (opts.json) std::printf("{\"summary\":true,");
+  else std::printf("\nsummary over %.1fs\n", elapsed);
+
+  for (int op = 0; op < OP_COUNT; op++) {
+    if (opts.json) {
+      std::printf("\"%s\":{\"ops\":%llu,\"errors\":%llu,\"ops_per_s\":%.1f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu},", op_names[op],
+        (unsigned long long)total.ops[op], (unsigned long long)total.errors[op], (double)total.ops[op] / elapsed,
+        (unsigned long long)total.p50[op], (unsigned long long)total.p99[op], (unsigned long long)total.p999[op]);
+    } else if (total.ops[op]) {
+      std::printf("  %-9s %12llu ops %12.0f ops/s  errors %llu  p50 %.1fus p99 %.1fus p99.9 %.1fus\n", op_names[op],
+        (unsigned long long)total.ops[op], (double)total.ops[op] / elapsed, (unsigned long long)total.errors[op],
+        (double)total.p50[op] / 1e3, (double)total.p99[op] / 1e3, (double)total.p999[op] / 1e3);
+    }
+  }
+
+  if (opts.json) {
+    std::printf("\"rss_before\":%llu,\"rss_loaded\":%llu,\"rss_end\":%llu", 
+      (unsigned long long)rss_before, (unsigned long long)rss_loaded, (unsigned long long)rss_end);
+  } else std::printf("  rss %.1f MiB at the end\n", (double)rss_end / (1024.0 * 1024.0));
+
+  if (engine_stats) {
+    if (opts.json) std::printf(",\"engine\":[");
+    else std::printf("\nengine stats (marshalling / execution, mean per call)\n");
+
+    bool first = true;
+    for (const CallStats::entry &e : engine_stats->snapshot()) {
+      double calls = (double)std::max<uint64_t>(e.calls, 1);
+      if (opts.json) {
+        std::printf("%s{\"name\":\"%s\",\"callback\":%s,\"calls\":%llu,\"marshal_ns\":%.1f,\"exec_ns\":%.1f,\"p99_ns\":%llu", first ? "" : ",",
+          e.name.c_str(), e.kind == CallStats::HOST_CALLBACK ? "true" : "false", (unsigned long long)e.calls,
+          (double)e.marshal_ns / calls, (double)e.exec_ns / calls, (unsigned long long)e.percentile(0.99));
+        if (e.counted) {
+          std::printf(",\"counted\":%llu", (unsigned long long)e.counted);
+          for (int i = 0; i < PerfCounters::counter_count; i++) {
+            std::printf(",\"%s\":%.1f", PerfCounters::name((PerfCounters::counter_t)i), (double)e.hardware[i] / (double)e.counted);
+          }
+        }
+        std::printf("}");
+      } else {
+        std::printf("  %-9s %-16s %12llu calls  %8.1fns / %8.1fns  p99 %.1fus\n", e.kind == CallStats::HOST_CALLBACK ? "callback" : "path",
+          e.name.c_str(), (unsigned long long)e.calls, (double)e.marshal_ns / calls, (double)e.exec_ns / calls, (double)e.percentile(0.99) / 1e3);
+        if (e.counted) {
+          double counted = (double)e.counted;
+          std::printf("  %-26s IPC %.2f  %.0f cycles  L1d %.1f  LLC %.1f  branch %.1f misses per call\n", "",
+            e.hardware[PerfCounters::CYCLES] ? (double)e.hardware[PerfCounters::INSTRUCTIONS] / (double)e.hardware[PerfCounters::CYCLES] : 0.0,
+            (double)e.hardware[PerfCounters::CYCLES] / counted, (double)e.hardware[PerfCounters::L1D_MISSES] / counted,
+            (double)e.hardware[PerfCounters::LLC_MISSES] / counted, (double)e.hardware[PerfCounters::BRANCH_MISSES] / counted);
+        }
+      }
+      first = false;
+    }
+
+    if (opts.json) std::printf("]");
+  }
+
+  if (opts.json) std::printf("}\n");
+  return 0;
+}
@@ -0,0 +1,146 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+/*
+ * Replays a call log (see State::record_calls) into fresh States at full speed, and compares the
+ * timings of every path against the recorded run, for performance regression testing.
+ * 
+ * Usage: yreplay <log> [--runs n] [--max-ratio r] [--format text|json]
+ * 
+ * Each run gets its own State; earlier runs only warm up, the last one is compared.
+ * With --max-ratio, exits with 3 when a path's replayed p50 exceeds r times the recorded one.
+ */
+
+#include "inc/types/state.hpp"
+#include "inc/types/calltrace.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace YumEngine::xV1;
+
+namespace {
+  struct options {
+    std::string log;
+    uint64_t    runs = 1;
+    double      max_ratio = 0;
+    bool        json = false;
+  };
+
+  bool parse(int argc, char **argv, options &opts) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+
+      if (arg == "--runs" && has_value) opts.runs = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+      else if (arg == "--max-ratio" && has_value) opts.max_ratio = std::atof(argv[++i]);
+      else if (arg == "--format" && has_value) opts.json = std::string(argv[++i]) == "json";
+      else if (opts.log.empty() && arg.rfind("--", 0) != 0) opts.log = arg;
+      else return false;
+    }
+
+    return !opts.log.empty();
+  }
+
+  double ratio(uint64_t replayed, uint64_t recorded) {
+    return recorded ? (double)replayed / (double)recorded : 0.0;
+  }
+
+  std::string json_escape(const std::string &text) {
+    std::string out;
+    for (char c : text) {
+      if (c == '"' || c == '\\') { out += '\\'; out += c; }
+      else if ((unsigned char)c < 0x20) { char hex[8]; std::snprintf(hex, sizeof(hex), "\\u%04x", c); out += hex; }
+      else out += c;
+    }
+    return out;
+  }
+}
+
+int main(int argc, char **argv) {
+  options opts;
+  if (!parse(argc, argv, opts)) {
+    std::fprintf(stderr, "usage: %s <log> [--runs n] [--max-ratio r] [--format text|json]\n", argv[0]);
+    return 2;
+  }
+
+  CallReplay replay;
+  std::string error;
+  if (!replay.open(opts.log.c_str(), error)) {
+    std::fprintf(stderr, "cannot replay %s: %s\n", opts.log.c_str(), error.c_str());
+    return 1;
+  }
+
+  for (uint64_t run = 0; run < opts.runs; run++) {
+    State state;
+    syserr_t err = replay.run(state);
+    if (err.category != syserr_t::OK) {
+      std::fprintf(stderr, "replay failed: %.*s\n", (int)err.comment.length, err.comment.start);
+      return 1;
+    }
+  }
+
+  std::vector<CallReplay::comparison> paths = replay.compare();
+  bool regressed = false;
+  for (const CallReplay::comparison &c : paths) {
+    if (opts.max_ratio > 0 && ratio(c.replayed_p50_ns, c.recorded_p50_ns) > opts.max_ratio) regressed = true;
+  }
+
+  if (opts.json) {
+    std::printf("{\"recorded_span_ns\":%llu,\"replayed_span_ns\":%llu,\"missing_callback_returns\":%llu,\"regressed\":%s,\"paths\":[",
+      (unsigned long long)replay.recorded_span_ns(), (unsigned long long)replay.replayed_span_ns(),
+      (unsigned long long)replay.missing_callback_returns(), regressed ? "true" : "false");
+    for (size_t i = 0; i < paths.size(); i++) {
+      const CallReplay::comparison &c = paths[i];
+      std::printf("%s{\"path\":\"%s\",\"calls\":%llu,\"recorded_errors\":%llu,\"replayed_errors\":%llu,"
+        "\"recorded_mean_ns\":%.1f,\"replayed_mean_ns\":%.1f,\"recorded_p50_ns\":%llu,\"replayed_p50_ns\":%llu,"
+        "\"recorded_p99_ns\":%llu,\"replayed_p99_ns\":%llu}", i ? "," : "", json_escape(c.path).c_str(),
+        (unsigned long long)c.calls, (unsigned long long)c.recorded_errors, (unsigned long long)c.replayed_errors,
+        c.recorded_mean_ns, c.replayed_mean_ns,
+        (unsigned long long)c.recorded_p50_ns, (unsigned long long)c.replayed_p50_ns,
+        (unsigned long long)c.recorded_p99_ns, (unsigned long long)c.replayed_p99_ns);
+    }
+    std::printf("]}\n");
+  } else {
+    std::printf("recorded over %.3f ms, replayed in %.3f ms\n", 
+      (double)replay.recorded_span_ns() / 1e6, (double)replay.replayed_span_ns() / 1e6);
+    if (replay.missing_callback_returns()) {
+      std::printf("warning: %llu callback calls had no recorded values, the replay diverged\n", 
+        (unsigned long long)replay.missing_callback_returns());
+    }
+
+    std::printf("%-40s %8s %12s %12s %7s %12s %12s %7s %6s\n", 
+      "path", "calls", "rec p50 ns", "rep p50 ns", "p50 x", "rec p99 ns", "rep p99 ns", "p99 x", "errors");
+    for (const CallReplay::comparison &c : paths) {
+      std::printf("%-40s %8llu %12llu %12llu %7.2f %12llu %12llu %7.2f %3llu/%-3llu\n", c.path.c_str(), (unsigned long long)c.calls,
+        (unsigned long long)c.recorded_p50_ns, (unsigned long long)c.replayed_p50_ns, ratio(c.replayed_p50_ns, c.recorded_p50_ns),
+        (unsigned long long)c.recorded_p99_ns, (unsigned long long)c.replayed_p99_ns, ratio(c.replayed_p99_ns, c.recorded_p99_ns),
+        (unsigned long long)c.recorded_errors, (unsigned long long)c.replayed_errors);
+    }
+  }
+
+  return regressed ? 3 : 0;
+}
@@ -0,0 +1,41 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#ifndef YUM_INCLUDE_GUARD_GC_SCHEDULER_C_H
+#define YUM_INCLUDE_GUARD_GC_SCHEDULER_C_H
+
+#include "_byumlibc.h"
+#include "inc/api/ystatec.h"
+#include "inc/types/base/types.h"
+
+typedef struct YumGcScheduler YumGcScheduler;
+
+yumlibcxx_c_header_decoration_begin
+
+YumGcScheduler *yumlibc_library_member(gcsched_new)(uint64_t nthreads, uint64_t period_us, uint64_t budget_us, uint64_t threshold);
+void            yumlibc_library_member(gcsched_delete)(YumGcScheduler *scheduler);
+void            yumlibc_library_member(gcsched_add)(YumGcScheduler *scheduler, YumState *state, boolean_t take_over);
+void            yumlibc_library_member(gcsched_remove)(YumGcScheduler *scheduler, YumState *state);
+
+yumlibcxx_c_header_decoration_end
+
+#endif // !YUM_INCLUDE_GUARD_GC_SCHEDULER_C_H
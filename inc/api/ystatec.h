@@ -30,15 +30,40 @@
 #include "inc/types/base/callbacks.h"
 
 typedef yumlibc_callback_type yumcallback_t;
+typedef yumlibc_ctxcallback_type yumctxcallback_t;
+typedef yumlibc_fastcallback_type yumfastcallback_t;
 typedef struct YumState YumState;
+typedef struct YumStateTemplate YumStateTemplate;
 
 yumlibcxx_c_header_decoration_begin
 
 YumState *yumlibc_library_member(new)(void);
+YumState *yumlibc_library_member(new_with)(const allocpolicy_t *policy);
+YumState *yumlibc_library_member(new_from)(const YumStateTemplate *source, const allocpolicy_t *policy);
+YumStateTemplate *yumlibc_library_member(capture)(YumState *state);
+void      yumlibc_library_member(delete_template)(const YumStateTemplate *source);
+boolean_t yumlibc_library_member(rebind_callback)(YumState *state, uint64_t id, void *context);
 void      yumlibc_library_member(open_libs)(YumState *state);
 void      yumlibc_library_member(delete)(const YumState *state);
 syserr_t  yumlibc_library_member(push_callback)(YumState *state, utf8 name, const yumcallback_t callback);
+syserr_t  yumlibc_library_member(push_ctxcallback)(YumState *state, utf8 name, const yumctxcallback_t callback, void *context, uint64_t *id);
+syserr_t  yumlibc_library_member(push_fastcallback)(YumState *state, utf8 name, const yumfastcallback_t callback, void *context, uint64_t *id);
+void      yumlibc_library_member(remove_callback)(YumState *state, uint64_t id);
 syserr_t  yumlibc_library_member(call)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, uint64_t *outc, variant_t **out);
+syserr_t  yumlibc_library_member(call_into)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, varframe_t *frame);
+syserr_t  yumlibc_library_member(call_borrowed)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, varframe_t *frame, callscope_t *scope);
+void      yumlibc_library_member(release_scope)(YumState *state, callscope_t *scope);
+syserr_t  yumlibc_library_member(call_visit)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, yumlibc_visitor_type visitor, void *context);
+syserr_t  yumlibc_library_member(resolve)(YumState *state, utf8 path, fnhandle_t *handle);
+syserr_t  yumlibc_library_member(call_handle)(YumState *state, const fnhandle_t *handle, uint64_t argc, const variant_t *argv, uint64_t *outc, variant_t **out);
+syserr_t  yumlibc_library_member(call_handle_into)(YumState *state, const fnhandle_t *handle, uint64_t argc, const variant_t *argv, varframe_t *frame);
+syserr_t  yumlibc_library_member(call_batch)(YumState *state, utf8 path, uint64_t count, uint64_t argc, const variant_t *argv, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t *nfailed);
+syserr_t  yumlibc_library_member(call_batch_handle)(YumState *state, const fnhandle_t *handle, uint64_t count, uint64_t argc, const variant_t *argv, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t *nfailed);
+void      yumlibc_library_member(release_handle)(YumState *state, fnhandle_t *handle);
+syserr_t  yumlibc_library_member(call_async)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, const timeslice_t *slice, taskhandle_t *task, boolean_t *done, uint64_t *outc, variant_t **out);
+syserr_t  yumlibc_library_member(call_handle_async)(YumState *state, const fnhandle_t *handle, uint64_t argc, const variant_t *argv, const timeslice_t *slice, taskhandle_t *task, boolean_t *done, uint64_t *outc, variant_t **out);
+syserr_t  yumlibc_library_member(resume)(YumState *state, const taskhandle_t *task, const timeslice_t *slice, boolean_t *done, uint64_t *outc, variant_t **out);
+void      yumlibc_library_member(cancel)(YumState *state, const taskhandle_t *task);
 syserr_t  yumlibc_library_member(push_variant)(YumState *state, utf8 name, const variant_t *var);
 syserr_t  yumlibc_library_member(push_table)(YumState *state, utf8 name);
 void      yumlibc_library_member(push_global)(YumState *state, utf8 name);
@@ -47,6 +72,33 @@ void      yumlibc_library_member(ensure_path)(YumState *state, utf8 path);
 syserr_t  yumlibc_library_member(run)(YumState *state, utf8 source, boolean_t isfile);
 syserr_t  yumlibc_library_member(load)(YumState *state, const lstring_t *source, boolean_t isfile);
 void      yumlibc_library_member(clear)(YumState *state);
+void      yumlibc_library_member(set_call_budget)(YumState *state, const callbudget_t *budget);
+void      yumlibc_library_member(interrupt)(YumState *state);
+void      yumlibc_library_member(start_profiler)(YumState *state, profmode_t mode, uint64_t period);
+void      yumlibc_library_member(stop_profiler)(YumState *state);
+void      yumlibc_library_member(reset_profile)(YumState *state);
+lstring_t yumlibc_library_member(profile_folded)(const YumState *state);
+uint64_t  yumlibc_library_member(profile_top)(const YumState *state, uint64_t n, profentry_t *entries);
+void      yumlibc_library_member(enable_call_stats)(YumState *state, boolean_t enable);
+void      yumlibc_library_member(share_call_stats)(YumState *state, const YumState *source);
+uint64_t  yumlibc_library_member(call_stats)(const YumState *state, uint64_t capacity, callstat_t *entries);
+boolean_t yumlibc_library_member(enable_hardware_counters)(YumState *state, boolean_t enable);
+syserr_t  yumlibc_library_member(record_calls)(YumState *state, utf8 path);
+void      yumlibc_library_member(flush_call_log)(YumState *state);
+void      yumlibc_library_member(gc_mode)(YumState *state, gcmode_t mode);
+boolean_t yumlibc_library_member(gc_step)(YumState *state, uint64_t budget_us);
+void      yumlibc_library_member(gc_collect)(YumState *state);
+void      yumlibc_library_member(gc_stop)(YumState *state);
+void      yumlibc_library_member(gc_restart)(YumState *state);
+boolean_t yumlibc_library_member(gc_running)(const YumState *state);
+void      yumlibc_library_member(gc_stats)(const YumState *state, gcstats_t *stats);
+void      yumlibc_library_member(gc_reset_stats)(YumState *state);
+void      yumlibc_library_member(use_bytecode_cache)(YumState *state, utf8 directory);
+void      yumlibc_library_member(use_large_pages)(YumState *state, boolean_t enabled);
+syserr_t  yumlibc_library_member(mount_archive)(YumState *state, utf8 path);
+syserr_t  yumlibc_library_member(write_archive)(utf8 path, uint64_t count, const utf8 *names, const lstring_t *sources, boolean_t precompile);
+void      yumlibc_library_member(memory_stats)(const YumState *state, memstats_t *stats);
+boolean_t yumlibc_library_member(set_memory_limit)(YumState *state, uint64_t limit);
 
 yumlibcxx_c_header_decoration_end
 
@@ -0,0 +1,51 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#ifndef YUM_INCLUDE_GUARD_STATE_POOL_C_H
+#define YUM_INCLUDE_GUARD_STATE_POOL_C_H
+
+#include "_byumlibc.h"
+#include "inc/api/ystatec.h"
+#include "inc/types/base/types.h"
+#include "inc/types/base/vardef.h"
+#include "inc/types/system/err.h"
+
+#define YUM_POOL_NO_AFFINITY UINT64_MAX
+
+typedef struct YumStatePool YumStatePool;
+
+/** @brief Initializes a State of a pool, on its worker thread. */
+typedef void (*yumlibc_pool_initializer_type)(YumState *state, void *context);
+
+/** @brief Receives the result of a pooled call, on a worker thread. You may free `out` with yumfree_array(). */
+typedef void (*yumlibc_pool_completion_type)(void *context, syserr_t err, uint64_t outc, variant_t *out);
+
+yumlibcxx_c_header_decoration_begin
+
+YumStatePool *yumlibc_library_member(pool_new)(uint64_t nthreads, yumlibc_pool_initializer_type initializer, void *context);
+void          yumlibc_library_member(pool_delete)(YumStatePool *pool);
+uint64_t      yumlibc_library_member(pool_size)(const YumStatePool *pool);
+syserr_t      yumlibc_library_member(pool_submit)(YumStatePool *pool, utf8 path, uint64_t argc, const variant_t *argv, uint64_t affinity, yumlibc_pool_completion_type completion, void *context);
+
+yumlibcxx_c_header_decoration_end
+
+#endif // !YUM_INCLUDE_GUARD_STATE_POOL_C_H
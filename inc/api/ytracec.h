@@ -0,0 +1,40 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#ifndef YUM_INCLUDE_GUARD_TRACE_C_H
+#define YUM_INCLUDE_GUARD_TRACE_C_H
+
+#include "_byumlibc.h"
+#include "inc/types/base/types.h"
+#include "inc/types/system/err.h"
+
+yumlibcxx_c_header_decoration_begin
+
+void      yumlibc_library_member(trace_enable)(uint32_t categories);
+uint32_t  yumlibc_library_member(trace_categories)(void);
+syserr_t  yumlibc_library_member(trace_write_chrome)(utf8 path);
+lstring_t yumlibc_library_member(trace_chrome_json)(void);
+void      yumlibc_library_member(trace_clear)(void);
+
+yumlibcxx_c_header_decoration_end
+
+#endif // !YUM_INCLUDE_GUARD_TRACE_C_H
@@ -20,19 +20,20 @@
  *                                                                                   *
  *************************************************************************************/
 
+/*
+ * Debug points are trace events of the YUM_TRACE_DEBUG category (see tracer.hpp), traced from the start in debug builds.
+ * They cost a branch while the category is not traced, and their arguments are only evaluated when it is.
+ */
+#include "inc/debug/tracer.hpp"
+
+#define YUM_DEBUG_HERE      YUM_TRACE_INSTANT(YUM_TRACE_DEBUG, __func__, {}, __LINE__)
+#define YUM_DEBUG_PUTS(w)   YUM_TRACE_INSTANT(YUM_TRACE_DEBUG, __func__, std::string_view(w), __LINE__)
+#define YUM_DEBUG_PUTL(s,l) YUM_TRACE_INSTANT(YUM_TRACE_DEBUG, __func__, std::string_view(s, l), __LINE__)
+#define YUM_DEBUG_OUTF      YUM_TRACE_INSTANT(YUM_TRACE_DEBUG, __func__, "exiting function", __LINE__)
+#define YUM_DEBUG_CHECKP(n) YUM_TRACE_INSTANT(YUM_TRACE_DEBUG, __func__, std::string_view(n), __LINE__)
+
 #ifdef DEBUG
-#include <stdio.h>
-#define YUM_DEBUG_HERE      printf("YUM-DEBUG-POINT-REACHED:\t%s:%u:%s\n", __FILE__, __LINE__, __func__);
-#define YUM_DEBUG_PUTS(w)   printf("YUM-DEBUG-POINT-REACHED:\t%s:%u:%s:%s\n", __FILE__, __LINE__, __func__, w);
-#define YUM_DEBUG_PUTL(s,l) printf("YUM-DEBUG-POINT-REACHED:\t%s:%u:%s:'%.*s'\n", __FILE__, __LINE__, __func__, l, s);
-#define YUM_DEBUG_OUTF      printf("YUM-DEBUG-POINT-REACHED:\t%s:%u:%s: exiting function\n", __FILE__, __LINE__, __func__);
-#define YUM_DEBUG_CHECKP(n) printf("YUM-DEBUG-POINT-REACHED:\t%s:%u:%s: check-point '%s'\n", __FILE__, __LINE__, __func__, n);
 #define YUM_DEBUG_CALL(...) { __VA_ARGS__; }
 #else
-#define YUM_DEBUG_HERE
-#define YUM_DEBUG_PUTS(w)
-#define YUM_DEBUG_PUTL(s,l)
-#define YUM_DEBUG_OUTF
-#define YUM_DEBUG_CHECKP(n)
 #define YUM_DEBUG_CALL(...) 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,105 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "inc/types/base/types.h"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief Process-wide event tracing. Trace points test one relaxed load against the enabled categories
+   * (see tracecat_t), then write a fixed-size binary event to a ring of the calling thread, without locks.
+   * Rings keep the last `ring_capacity` events of each thread, and are exported as Chrome trace-event JSON
+   * (chrome://tracing, Perfetto). The ring of an exited thread is kept until a new thread takes it over.
+   */
+  class Tracer {
+  public:
+    /** @brief One event, as stored in rings. */
+    struct event {
+      uint64_t    ts_ns;         // Steady clock.
+      uint64_t    dur_ns;        // Complete events only.
+      uint64_t    value;         // Event-specific: freed bytes, failure, counter value, source line...
+      const char *name;          // Static string.
+      uint8_t     category;      // Bit index in tracecat_t.
+      char        phase;         // 'X' complete, 'i' instant, 'C' counter, as in the Chrome format.
+      uint8_t     detail_length;
+      char        detail[29];    // Path, callback or chunk name, truncated.
+    };
+
+    static_assert(sizeof(event) == 64, "trace events fill one cache line");
+
+    /** @brief Events kept per thread (1 MiB). */
+    static constexpr uint64_t ring_capacity = (uint64_t)1 << 14;
+
+  private:
+    static std::atomic<uint32_t> mask;
+
+    static void push(uint32_t category, char phase, const char *name, uint64_t ts_ns, uint64_t dur_ns, std::string_view detail, uint64_t value);
+
+  public:
+    /** @brief Whether a category is traced. The only cost of a trace point while it is not. */
+    static inline bool on(uint32_t category) { return (mask.load(std::memory_order_relaxed) & category) != 0; }
+
+    /** @brief Traces the given categories (a tracecat_t mask), and only them. 0 stops tracing. */
+    static void enable(uint32_t categories);
+
+    /** @brief The traced categories. */
+    static uint32_t categories();
+
+    /** @brief The clock of events, in nanoseconds. */
+    static uint64_t now();
+
+    /** @brief Records a span from `start_ns` (see now()) to now. `name` must be a static string. */
+    static void complete(uint32_t category, const char *name, uint64_t start_ns, std::string_view detail = {}, uint64_t value = 0);
+
+    /** @brief Records a point in time. `name` must be a static string. */
+    static void instant(uint32_t category, const char *name, std::string_view detail = {}, uint64_t value = 0);
+
+    /** @brief Records the value of a counter, drawn as a graph. `name` must be a static string. */
+    static void counter(uint32_t category, const char *name, uint64_t value);
+
+    /**
+     * @brief Events of every thread, as Chrome trace-event JSON. Threads keep tracing meanwhile:
+     * events overwritten while they were read are dropped.
+     */
+    static std::string chrome_json();
+
+    /** @brief Writes chrome_json() to a file. */
+    static bool write_chrome_json(utf8 path);
+
+    /** @brief Forgets the events recorded so far. */
+    static void clear();
+  };
+}
+
+/** @brief Traces a span from `start` (Tracer::now()) to here, if `category` is traced. */
+#define YUM_TRACE_COMPLETE(category, name, start, ...) \
+  { if (YumEngine::xV1::Tracer::on(category)) [[unlikely]] YumEngine::xV1::Tracer::complete(category, name, start __VA_OPT__(,) __VA_ARGS__); }
+
+/** @brief Traces a point in time, if `category` is traced. Arguments are only evaluated then. */
+#define YUM_TRACE_INSTANT(category, name, ...) \
+  { if (YumEngine::xV1::Tracer::on(category)) [[unlikely]] YumEngine::xV1::Tracer::instant(category, name __VA_OPT__(,) __VA_ARGS__); }
@@ -0,0 +1,80 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "inc/types/base/vardef.h"
+#include "inc/types/variant.hpp"
+
+#include <vector>
+
+namespace YumEngine::xV1::Sdk {
+  /**
+   * @brief A reusable frame receiving the values returned by SdkState::call().
+   * When a call's results do not fit, the frame grows to the required sizes. Once warmed up, calls allocate nothing.
+   */
+  class Frame {
+  private:
+    std::vector<variant_t> values;
+    std::vector<char>      arena;
+    varframe_t             raw = {};
+
+  public:
+    /**
+     * @brief Creates a frame.
+     * 
+     * @param capacity Count of values the frame can receive.
+     * @param arena_capacity Count of bytes strings and binaries can take.
+     */
+    inline Frame(uint64_t capacity = 8, uint64_t arena_capacity = 256) {
+      reserve(capacity, arena_capacity);
+    }
+
+    /**
+     * @brief Grows the frame. Never shrinks it.
+     * 
+     * @param capacity Count of values the frame can receive.
+     * @param arena_capacity Count of bytes strings and binaries can take.
+     */
+    inline void reserve(uint64_t capacity, uint64_t arena_capacity) {
+      if (capacity > values.size()) values.resize(capacity);
+      if (arena_capacity > arena.size()) arena.resize(arena_capacity);
+
+      raw.values = values.data();
+      raw.capacity = values.size();
+      raw.arena = arena.data();
+      raw.arena_capacity = arena.size();
+    }
+
+    /** @brief Count of values returned by the last call. */
+    inline uint64_t length() const { return raw.count; }
+
+    /** 
+     * @brief Returns a value. Its string or binary lives in the frame until the next call. 
+     * @warning Does not check bounds.
+     */
+    inline CVariant operator[](uint64_t i) const { return CVariant(raw.values[i]); }
+
+    inline varframe_t &c() { return raw; }
+    inline const varframe_t &c() const { return raw; }
+  };
+}
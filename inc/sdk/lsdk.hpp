@@ -25,6 +25,7 @@
 #include "inc/types/state.hpp"
 #include "inc/sdk/lbuffer.hpp"
 #include "inc/sdk/lstring.hpp"
+#include "inc/sdk/lframe.hpp"
 #include "inc/types/variant.hpp"
 
 #include <functional> // Include std::function<R(Args...)> type.
@@ -58,6 +59,48 @@ namespace YumEngine::xV1::Sdk {
      */
     containers::list<CVariant> call(const StringView &name);
 
+    /**
+     * @brief Calls a Lua function, writing its returned values into a reusable frame.
+     * 
+     * @param name The name of the function.
+     * @param buff Arguments of the call.
+     * @param frame Receives the returned values. If it is too small, it grows to fit them.
+     */
+    void                       call(const StringView &name, const Buffer<CVariant> &buff, Frame &frame);
+
+    /**
+     * @brief Resolves a Lua function once, so later calls skip the path walk.
+     * 
+     * @param name The name of the function.
+     * @return A handle to give to SdkState::call(). You may release it with SdkState::release().
+     */
+    fnhandle_t                 resolve(const StringView &name);
+
+    /**
+     * @brief Calls a resolved Lua function.
+     * 
+     * @param handle A handle given by SdkState::resolve().
+     * @param buff Arguments of the call.
+     * @return The returned values of the Lua function in a buffer. Throws if the function or a table on its path got reassigned.
+     */
+    containers::list<CVariant> call(const fnhandle_t &handle, const Buffer<CVariant> &buff);
+
+    /**
+     * @brief Calls a resolved Lua function, writing its returned values into a reusable frame.
+     * 
+     * @param handle A handle given by SdkState::resolve().
+     * @param buff Arguments of the call.
+     * @param frame Receives the returned values. If it is too small, it grows to fit them.
+     */
+    void                       call(const fnhandle_t &handle, const Buffer<CVariant> &buff, Frame &frame);
+
+    /**
+     * @brief Releases a resolved function.
+     * 
+     * @param handle A handle given by SdkState::resolve().
+     */
+    void                       release(fnhandle_t &handle);
+
     /**
      * @brief Pushes a value inside the Lua VM.
      * 
@@ -82,6 +125,33 @@ namespace YumEngine::xV1::Sdk {
      */
     void                       push_callback(const StringView &name, SdkCallback callback);
 
+    /**
+     * @brief Pushes a callback to the Lua VM, with a context pointer given back on every call.
+     * 
+     * @param name The name of the function.
+     * @param callback A function pointer.
+     * @param context Given back to the callback.
+     * @return An id, to give to SdkState::remove_callback().
+     */
+    uint64_t                   push_callback(const StringView &name, yum_ctxcallback callback, void *context);
+
+    /**
+     * @brief Pushes an allocation-free callback to the Lua VM (see yumlibc_fastcallback_type).
+     * 
+     * @param name The name of the function.
+     * @param callback A function pointer.
+     * @param context Given back to the callback.
+     * @return An id, to give to SdkState::remove_callback().
+     */
+    uint64_t                   push_callback(const StringView &name, yum_fastcallback callback, void *context);
+
+    /**
+     * @brief Removes a callback. Lua functions still referring to it raise an error when called.
+     * 
+     * @param id An id given by SdkState::push_callback().
+     */
+    void                       remove_callback(uint64_t id);
+
     /**
      * @brief Opens Lua's standard library.
      */
@@ -0,0 +1,85 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "base/types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief Lua allocator of a State, given to lua_newstate. Accounts live and peak bytes, enforces a hard cap,
+   * and may serve small blocks from size-class pools. A State only runs on one thread at a time, so the pools
+   * need no lock: they act as a thread cache owned by the State.
+   * The cap bounds what the State takes from the underlying allocator, not only its live bytes: pool chunks count
+   * whole, and stay taken until the State closes. A script freeing blocks of a class only makes room for that class.
+   */
+  class Allocator {
+  public:
+    /** @brief Pooled blocks are rounded up to a multiple of this. */
+    static constexpr uint64_t size_class_step = 16;
+    /** @brief Count of size classes. Bigger blocks go to the underlying allocator. */
+    static constexpr uint64_t size_classes    = 16;
+    /** @brief Pools carve their blocks from chunks of this size. */
+    static constexpr uint64_t chunk_size      = 64 * 1024;
+
+  private:
+    struct free_block { free_block *next; };
+
+    allocpolicy_t      policy;
+    memstats_t         counters = {};
+    free_block        *free_lists[size_classes] = {};
+    char              *chunk_cursor = nullptr;
+    char              *chunk_end = nullptr;
+    std::vector<void*> chunks;
+    std::vector<std::pair<void*, size_t>> adopted; // Underlying blocks shrunk in place into a pool, and their sizes.
+
+    static inline bool     pooled_size(size_t size) { return size > 0 && size <= size_class_step * size_classes; }
+    static inline uint64_t class_of(size_t size)    { return (size - 1) / size_class_step; }
+
+    void *underlying(void *ptr, size_t osize, size_t nsize);
+    void *capped(void *ptr, size_t osize, size_t nsize);
+    void *pool_take(uint64_t cls);
+    void  pool_give(void *ptr, uint64_t cls);
+    void *resize(void *ptr, size_t osize, size_t nsize);
+
+  public:
+    Allocator(const allocpolicy_t &policy);
+    ~Allocator();
+
+    Allocator(const Allocator&) = delete;
+    Allocator &operator=(const Allocator&) = delete;
+
+    /** @brief lua_Alloc entry point, `ud` being the Allocator. */
+    static void *lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+    /** @brief Current counters. */
+    memstats_t stats() const;
+
+    /** @brief Changes the hard cap on reserved bytes. 0 for no cap. Memory already held stays. */
+    void set_limit(uint64_t limit);
+  };
+}
@@ -0,0 +1,98 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "system/mappedfile.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief A YumEngine script archive, mapped read-only. One file holding Lua modules, as source or bytecode,
+   * behind an open-addressing index keyed by module name: finding a module costs one hash and a few probes.
+   *
+   * Layout (little-endian, every section 8-byte aligned):
+   *   header | entries[count] | buckets[bucket_count] | names and chunks
+   * A bucket holds an entry index plus one, 0 when empty. bucket_count is a power of two.
+   */
+  class Archive {
+  public:
+    static constexpr char     magic[4] = { 'Y', 'A', 'R', '1' };
+    static constexpr uint32_t bytecode = 1; // Entry flag: the chunk is lua_dump output.
+
+    struct header {
+      char     magic[4];
+      uint32_t count;
+      uint32_t bucket_count;
+      uint32_t reserved;
+      uint64_t entries_offset;
+      uint64_t buckets_offset;
+    };
+
+    struct entry {
+      uint64_t hash;
+      uint64_t name_offset;
+      uint64_t chunk_offset;
+      uint64_t chunk_length;
+      uint32_t name_length;
+      uint32_t flags;
+    };
+
+    /** @brief A module to pack. */
+    struct source {
+      std::string name;  // As given to require, "a.b.c".
+      std::string chunk; // Lua source.
+    };
+
+  private:
+    MappedFile      file;
+    std::string     path;
+    const header   *head    = nullptr;
+    const entry    *entries = nullptr;
+    const uint32_t *buckets = nullptr;
+
+  public:
+    /**
+     * @brief Maps and validates an archive.
+     * @return false with `error` set if the file is not a valid archive.
+     */
+    bool open(const char *path, std::string &error);
+
+    /** @brief Finds a module, nullptr if the archive does not have it. */
+    const entry *find(std::string_view name) const;
+
+    inline std::string_view name(const entry &e) const  { return { file.data() + e.name_offset, e.name_length }; }
+    inline std::string_view chunk(const entry &e) const { return { file.data() + e.chunk_offset, (size_t)e.chunk_length }; }
+    inline const std::string &location() const { return path; }
+
+    /**
+     * @brief Writes an archive.
+     * @param precompile Stores bytecode instead of sources. Bytecode is only valid for the Lua version that wrote it.
+     * @return false with `error` set if a module does not compile or the file cannot be written.
+     */
+    static bool write(const char *path, const std::vector<source> &sources, bool precompile, std::string &error);
+  };
+}
@@ -30,4 +30,28 @@
 
 typedef variant_t *(*yumlibc_callback_type)(uint64_t, const variant_t*, uint64_t*);
 
+/** @brief Same as yumlibc_callback_type, receiving the context pointer given when the callback was pushed. */
+typedef variant_t *(*yumlibc_ctxcallback_type)(void *context, uint64_t, const variant_t*, uint64_t*);
+
+/**
+ * @brief Allocation-free callback. Nothing is allocated per call, neither by the engine nor by the callback.
+ * Arguments live in an engine-owned buffer, their strings, binaries and tables are borrowed from Lua and only
+ * valid during the call. Results go into `out`, an engine-owned frame: write at most `out->capacity` values and
+ * set `out->count`. Returned strings may live in `out->arena`, or in any memory valid until the callback returns.
+ * Return yumfalse to raise a Lua error, with the string in `out->values[0]` (if any) as message.
+ */
+typedef boolean_t (*yumlibc_fastcallback_type)(void *context, uint64_t argc, const variant_t *argv, varframe_t *out);
+
+/**
+ * @brief Grows a frame a call found too small, to at least `frame->count` values and `frame->arena_used` bytes.
+ * The returned values are still pinned, and get converted into the grown frame. Return yumfalse if it cannot grow.
+ */
+typedef boolean_t (*yumlibc_framegrow_type)(void *context, varframe_t *frame);
+
+/**
+ * @brief Receives the values returned by a call, one after another. Borrowed strings and binaries are only valid
+ * during the visit. Returns yumfalse to stop the visit.
+ */
+typedef boolean_t (*yumlibc_visitor_type)(void *context, uint64_t index, const variant_t *value);
+
 #endif // !YUM_INCLUDE_GUARD_CALLBACK_TYPEDEF_H
\ No newline at end of file
@@ -31,6 +31,7 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 
 typedef int64_t     integer_t;
 typedef double      number_t;
@@ -55,4 +56,163 @@ typedef struct {
   boolean_t      owns;
 } binary_t;
 
+/** @brief Packed array of integers. Read back from Lua sequences holding only integers. */
+typedef struct {
+  const integer_t *start;
+  uint64_t         length;
+  boolean_t        owns;
+} intarray_t;
+
+/** @brief Packed array of numbers. Read back from Lua sequences holding only numbers, floats among them. */
+typedef struct {
+  const number_t *start;
+  uint64_t        length;
+  boolean_t       owns;
+} numarray_t;
+
+/**
+ * @brief A Lua function resolved once from its path, anchored in the registry of the State that resolved it.
+ * Calling through a handle skips the path lookups; every table on the path stays anchored and is only compared
+ * by identity. The handle becomes invalid once the function or any table on its path is reassigned.
+ * Release it with the State that created it.
+ */
+typedef struct {
+  int32_t function;
+  int32_t chain;
+  int32_t key;
+} fnhandle_t;
+
+/**
+ * @brief Keeps the values returned by a borrowing call alive, in a registry table, until released.
+ * Strings and binaries borrowed from nested tables are pinned there too.
+ * Borrowed strings and binaries (`owns == false`) point into Lua memory, and are only valid while their scope is.
+ * Scopes leave the Lua stack alone, and may be released in any order.
+ */
+typedef struct {
+  int32_t pin;   /* Registry reference of the table holding the values. */
+  int32_t count; /* Values and strings pinned, 0 when nothing is. */
+} callscope_t;
+
+/**
+ * @brief Underlying allocator, with the semantics of lua_Alloc: frees when `nsize` is 0, (re)allocates otherwise.
+ * `osize` is the size of `ptr`, 0 when `ptr` is NULL.
+ */
+typedef void *(*yumalloc_fn)(void *userdata, void *ptr, size_t osize, size_t nsize);
+
+/** @brief How a State allocates its Lua memory. Zero-initialize it for the defaults. */
+typedef struct {
+  yumalloc_fn alloc;    /* Underlying allocator. NULL for malloc/realloc/free. */
+  void       *userdata; /* Given back to `alloc`. */
+  boolean_t   pooled;   /* Serve small blocks from per-State size-class pools. */
+  uint64_t    limit;    /* Hard cap of the bytes taken from `alloc` (see memstats_t.reserved). Allocations over it fail
+                           with a Lua memory error. 0 for no cap. */
+} allocpolicy_t;
+
+/** @brief Memory counters of a State. */
+typedef struct {
+  uint64_t live;        /* Bytes currently held by Lua. */
+  uint64_t peak;        /* Highest `live` seen. */
+  uint64_t limit;       /* Current cap, 0 for none. */
+  uint64_t allocations; /* Count of new blocks. */
+  uint64_t failures;    /* Count of refused allocations. */
+  uint64_t reserved;    /* Bytes taken from the underlying allocator: pool chunks count whole, freed pooled blocks stay. */
+} memstats_t;
+
+/**
+ * @brief A call running on its own coroutine, resumed slice by slice until it completes.
+ * Released by the State when the call completes or fails. Cancel it if it is abandoned.
+ */
+typedef struct {
+  uint32_t index;
+  uint32_t generation;
+} taskhandle_t;
+
+/** @brief How long a task runs per resume. 0 leaves a limit off. With both off, a task runs until it ends or yields. */
+typedef struct {
+  uint64_t instructions;
+  uint64_t time_us;
+} timeslice_t;
+
+/**
+ * @brief Limits of every call of a State (calls, batches, run). 0 leaves a limit off.
+ * A call over its budget fails with BUDGET_EXCEEDED, and the State stays usable.
+ */
+typedef struct {
+  uint64_t instructions;
+  uint64_t time_us;
+} callbudget_t;
+
+/** @brief How the sampling profiler of a State decides to take a sample. */
+typedef enum {
+  YUM_PROFILE_INSTRUCTIONS, /* Every `period` Lua instructions. */
+  YUM_PROFILE_TIME,         /* Every `period` microseconds of wall-clock time, while Lua runs. */
+} profmode_t;
+
+/** @brief A function of a profile. `self` counts samples where it was running, `total` where it was on the stack. */
+typedef struct {
+  lstring_t frame;
+  uint64_t  self;
+  uint64_t  total;
+} profentry_t;
+
+/**
+ * @brief Counters of a Lua path called by the host, or of a host callback called by Lua. Times in nanoseconds.
+ * Percentiles are of the total latency (marshalling and execution), within 12.5%.
+ * Hardware counters are sums over the `counted` calls, user space only; 0 where the CPU lacks one.
+ */
+typedef struct {
+  lstring_t name;
+  boolean_t callback;   /* A host callback, by the name it was pushed with. */
+  uint64_t  calls;
+  uint64_t  errors;
+  uint64_t  marshal_ns; /* Path walks and conversions between variants and Lua values. */
+  uint64_t  exec_ns;    /* Running the Lua function, or the host callback. */
+  uint64_t  p50_ns;
+  uint64_t  p90_ns;
+  uint64_t  p99_ns;
+  uint64_t  p999_ns;
+  uint64_t  max_ns;
+  uint64_t  counted;    /* Calls measured by hardware counters (see enable_hardware_counters). */
+  uint64_t  cycles;
+  uint64_t  instructions;
+  uint64_t  l1d_misses;
+  uint64_t  llc_misses;
+  uint64_t  branch_misses;
+} callstat_t;
+
+/** @brief Categories of trace events, combined as a mask. */
+typedef enum {
+  YUM_TRACE_CALLS     = 1 << 0, /* Calls into Lua by the host: call, call_batch. */
+  YUM_TRACE_CALLBACKS = 1 << 1, /* Host callbacks called by Lua. */
+  YUM_TRACE_GC        = 1 << 2, /* Collections driven by the host or a GC scheduler. */
+  YUM_TRACE_TASKS     = 1 << 3, /* Slices of tasks (call_async, resume). */
+  YUM_TRACE_LOADS     = 1 << 4, /* Chunks compiled by run and load. */
+  YUM_TRACE_DEBUG     = 1 << 5, /* Debug points of the engine (YUM_DEBUG_*). */
+  YUM_TRACE_ALL       = (1 << 6) - 1,
+} tracecat_t;
+
+/** @brief Collector modes of a State. */
+typedef enum {
+  YUM_GC_INCREMENTAL,
+  YUM_GC_GENERATIONAL,
+} gcmode_t;
+
+/** @brief Count of buckets of GC pause histograms. */
+#define YUM_GC_PAUSE_BUCKETS 16
+
+/**
+ * @brief Counters of the collections a host drives (steps and full collections).
+ * Bucket 0 of `pauses` counts pauses under 1 microsecond, bucket i > 0 pauses in [2^(i-1), 2^i) microseconds,
+ * and the last bucket everything longer.
+ */
+typedef struct {
+  uint64_t steps;           /* gc_step calls. */
+  uint64_t cycles;          /* Cycles completed by steps. */
+  uint64_t collections;     /* Full collections. */
+  uint64_t collected_bytes; /* Bytes freed by steps and full collections. */
+  uint64_t total_ns;        /* Time spent in steps and full collections. */
+  uint64_t max_ns;          /* Longest step or full collection. */
+  uint64_t pauses[YUM_GC_PAUSE_BUCKETS];
+} gcstats_t;
+
 #endif // YUM_INCLUDE_GUARD_TYPES_H
\ No newline at end of file
@@ -27,6 +27,21 @@
 
 #include "types.h"
 
+struct variant_struct;
+
+/**
+ * @brief A Lua table read back to the host. Array-shaped tables have no keys (`keys` is NULL) and keep their order.
+ * Map-shaped tables have one key per value. A table owning its memory holds every nested table, string and binary
+ * in the same allocation, starting at the table itself. Free it with yumfree_table().
+ * A nested table referenced several times is read back once, and shared by the variants referencing it.
+ */
+typedef struct {
+  struct variant_struct *keys;
+  struct variant_struct *values;
+  uint64_t               length;
+  boolean_t              owns;
+} vartable_t;
+
 /**
  * @brief variant type, holding a value which can change between several types.
  * Used by the engine in order to communicate between the engine and Lua.
@@ -40,6 +55,9 @@ struct variant_struct {
     vuid_t    uid;
     lstring_t lstring;
     binary_t  binary;
+    vartable_t *table;
+    intarray_t integers;
+    numarray_t numbers;
   } hold;
   
   enum {
@@ -50,9 +68,27 @@ struct variant_struct {
     VARIANT_STRING,
     VARIANT_BINARY,
     VARIANT_UID,
+    VARIANT_TABLE,
+    VARIANT_INTEGER_ARRAY,
+    VARIANT_NUMBER_ARRAY,
   } type;
 };
 
 typedef struct variant_struct variant_t;
 
+/**
+ * @brief Caller-owned block receiving the values returned by a call, reusable from a call to another.
+ * Strings and binaries are copied into `arena`, and do not own their memory.
+ * When the frame is too small, the call reports BUFFER_OVERFLOW and sets `count` and `arena_used`
+ * to the required sizes, so the caller can grow the frame.
+ */
+typedef struct {
+  variant_t *values;
+  uint64_t   capacity;
+  uint64_t   count;
+  char      *arena;
+  uint64_t   arena_capacity;
+  uint64_t   arena_used;
+} varframe_t;
+
 #endif // YUM_INCLUDE_GUARD_VARDEF_H
\ No newline at end of file
@@ -0,0 +1,135 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "inc/types/system/perfcounters.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief Call counts and latencies of Lua paths and host callbacks, recorded by the States using it.
+   * Every thread records into its own shard, without locks. Snapshots read the shards while they are written.
+   * @note Latencies go in a log-linear histogram: exact under 8 ns, then 8 buckets per power of two (12.5% precision),
+   * up to 2^40 ns (about 18 minutes). Longer calls land in the last bucket.
+   * @note With count_hardware(), calls also sum the hardware counters of their thread (see PerfCounters), where it can count.
+   */
+  class CallStats {
+  public:
+    /** @brief What a name stands for. */
+    enum kind_t : uint8_t { 
+      LUA_PATH,      // A Lua function called by the host, through its path (or `<resolved handle>`).
+      HOST_CALLBACK, // A host callback called by Lua, by the name it was pushed with.
+    };
+
+    static constexpr int sub_buckets  = 8;
+    static constexpr int max_exponent = 40;
+    static constexpr int bucket_count = sub_buckets * (max_exponent - 2);
+
+    /** @brief Counters of a name, merged from every thread. */
+    struct entry {
+      std::string           name;
+      kind_t                kind;
+      uint64_t              calls;
+      uint64_t              errors;
+      uint64_t              marshal_ns; // Path walks and conversions between variants and Lua values.
+      uint64_t              exec_ns;    // Running the Lua function, or the host callback.
+      uint64_t              max_ns;
+      std::vector<uint64_t> histogram;  // Calls per bucket of total latency.
+      uint64_t              counted;    // Calls measured by hardware counters, which `hardware` sums.
+      uint64_t              hardware[PerfCounters::counter_count];
+
+      /** @brief Latency under which `q` (0 to 1) of the calls completed, by the upper bound of its bucket. */
+      uint64_t percentile(double q) const;
+    };
+
+  private:
+    struct counters {
+      std::atomic<uint64_t> calls{0};
+      std::atomic<uint64_t> errors{0};
+      std::atomic<uint64_t> marshal_ns{0};
+      std::atomic<uint64_t> exec_ns{0};
+      std::atomic<uint64_t> max_ns{0};
+      std::atomic<uint64_t> histogram[bucket_count] = {};
+      std::atomic<uint64_t> counted{0};
+      std::atomic<uint64_t> hardware[PerfCounters::counter_count] = {};
+    };
+
+    struct name_hash {
+      using is_transparent = void;
+      inline size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    using name_map = std::unordered_map<std::string, std::unique_ptr<counters>, name_hash, std::equal_to<>>;
+
+    /** @brief Counters of one thread. Only that thread writes them, and only it adds names, under `lock`. */
+    struct shard {
+      std::mutex lock;
+      name_map   names[2];
+    };
+
+    const uint64_t                      id;
+    std::atomic<bool>                   hardware{false};
+    mutable std::mutex                  shards_lock;
+    std::vector<std::unique_ptr<shard>> shards;
+
+    /** @brief The shard of the calling thread, created on its first record. */
+    shard &local();
+
+  public:
+    CallStats();
+    CallStats(const CallStats&) = delete;
+    CallStats &operator=(const CallStats&) = delete;
+
+    /**
+     * @brief Records a call of `name`. Lock-free, but for the first call of a name on a thread.
+     * @param counted What the hardware counters counted during the call, if they were read.
+     */
+    void record(kind_t kind, std::string_view name, bool failed, uint64_t marshal_ns, uint64_t exec_ns, 
+                const PerfCounters::sample *counted = nullptr);
+
+    /** @brief Asks the States recording here to read the hardware counters around calls and callbacks. Off by default. */
+    inline void count_hardware(bool enable) { hardware.store(enable, std::memory_order_relaxed); }
+
+    /** @brief Whether calls should be measured by hardware counters. */
+    inline bool counts_hardware() const { return hardware.load(std::memory_order_relaxed); }
+
+    /** @brief Counters of every name, sorted by kind then name. Does not stop recording threads. */
+    std::vector<entry> snapshot() const;
+
+    /** @brief Histogram bucket of a latency. */
+    static int bucket_of(uint64_t ns);
+
+    /** @brief Highest latency of a histogram bucket. */
+    static uint64_t bucket_limit(int bucket);
+  };
+}
+
+using YumCallStats = YumEngine::xV1::CallStats;
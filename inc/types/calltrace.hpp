@@ -0,0 +1,187 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "base/types.h"
+#include "base/vardef.h"
+#include "system/err.h"
+#include "callstats.hpp"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace YumEngine::xV1 {
+  class State;
+
+  /**
+   * @brief Binary log of what a host does with a State: setup (tables, callbacks, pushes, scripts), calls with their
+   * arguments and timings, and the values callbacks return. Replayed by CallReplay.
+   * @note The log is in the byte order of the recording machine. Handle calls are logged by path.
+   */
+  class CallRecorder {
+  public:
+    /** @brief Operations of the log. */
+    enum op_t : uint8_t {
+      OPEN_STDLIBS = 1,
+      GLOBAL,          // push_global
+      TABLE,           // push_table
+      NEW_TABLE,
+      ENSURE_PATH,
+      CLEAR,
+      CALLBACK,        // push_callback, of any kind
+      PUSH,            // push_variant
+      RUN,
+      LOAD,
+      CALL,            // call, call_batch (once per item)
+      RETURN,          // Values returned by a callback
+    };
+
+    static constexpr char     magic[4] = { 'Y', 'C', 'T', '1' };
+    static constexpr uint32_t version  = 1;
+
+  private:
+    std::mutex        lock;
+    FILE             *file = nullptr;
+    std::vector<char> buffer;
+    uint64_t          origin_ns = 0;
+
+    void begin(op_t op);
+    void put(const void *data, size_t length);
+    void put_u8(uint8_t value);
+    void put_u32(uint32_t value);
+    void put_u64(uint64_t value);
+    void put_text(std::string_view text);
+    void put_variant(const variant_t &value);
+    void flush_locked();
+
+  public:
+    CallRecorder() = default;
+    CallRecorder(const CallRecorder&) = delete;
+    CallRecorder &operator=(const CallRecorder&) = delete;
+    ~CallRecorder();
+
+    /** @brief Starts a log in `path`, replacing it. */
+    bool open(utf8 path, std::string &error);
+
+    /** @brief Writes what is buffered. */
+    void flush();
+
+    /** @brief Flushes and closes the log. Later records are dropped. */
+    void close();
+
+    /** @brief Whether a log is open. */
+    inline bool is_open() const { return file != nullptr; }
+
+    void text(op_t op, std::string_view text);
+    void push(std::string_view name, const variant_t &value);
+    void source(op_t op, std::string_view source, bool isfile);
+    void call(std::string_view path, uint64_t argc, const variant_t *args, uint64_t start_ns, uint64_t duration_ns, bool failed);
+    void callback_return(std::string_view name, uint64_t count, const variant_t *values);
+  };
+
+  /**
+   * @brief Replays a CallRecorder log into a fresh State, at full speed, and compares the timings of calls with
+   * the recorded ones. Callbacks are not called: they return what they returned when recorded, in order.
+   * @note Calls made by callbacks are replayed on their own, as the callbacks are not run. Returned values are not translated.
+   */
+  class CallReplay {
+  public:
+    /** @brief Timings of a path, recorded and replayed. Times in nanoseconds. */
+    struct comparison {
+      std::string path;
+      uint64_t    calls;
+      uint64_t    recorded_errors;
+      uint64_t    replayed_errors;
+      double      recorded_mean_ns;
+      double      replayed_mean_ns;
+      uint64_t    recorded_p50_ns;
+      uint64_t    replayed_p50_ns;
+      uint64_t    recorded_p99_ns;
+      uint64_t    replayed_p99_ns;
+    };
+
+  private:
+    friend class State;
+
+    struct record {
+      CallRecorder::op_t op;
+      bool               failed;
+      bool               isfile;
+      uint64_t           ts_ns;
+      uint64_t           duration_ns;
+      std::string_view   text;        // NUL-terminated in `data`.
+      uint64_t           first_value;
+      uint64_t           value_count;
+    };
+
+    /** @brief Values returned by a callback, in order, and the next one to give. */
+    struct returns {
+      std::vector<uint64_t> records;
+      uint64_t              next = 0;
+    };
+
+    std::string                                     data;
+    std::vector<record>                             records;
+    std::vector<variant_t>                          values;        // Arguments and returned values, by record.
+    std::deque<std::vector<variant_t>>              nested_values; // Of tables.
+    std::deque<vartable_t>                          tables;
+    std::deque<std::string>                         arrays;        // Aligned copies of packed arrays.
+    std::unordered_map<std::string_view, returns>   callback_returns;
+
+    std::unique_ptr<CallStats> recorded;
+    std::unique_ptr<CallStats> replayed;
+    uint64_t  missing_returns = 0;
+    uint64_t  replay_ns = 0;
+
+    bool read_variant(size_t &at, variant_t &out, int depth);
+
+    /** @brief The next values recorded for callback `name`. None once they are all given. */
+    void next_return(std::string_view name, uint64_t &count, const variant_t *&out);
+
+  public:
+    /** @brief Reads a log. */
+    bool open(utf8 path, std::string &error);
+
+    /** @brief Replays the log into `state`, which should be fresh. Can be repeated on other States. */
+    syserr_t run(State &state);
+
+    /** @brief Recorded and replayed timings of every path called, sorted by path. */
+    std::vector<comparison> compare() const;
+
+    /** @brief Time between the first and the last record, when recorded. */
+    uint64_t recorded_span_ns() const;
+
+    /** @brief Time the last run took. */
+    inline uint64_t replayed_span_ns() const { return replay_ns; }
+
+    /** @brief Callback calls that had no recorded values left, in the last run: the replay diverged. */
+    inline uint64_t missing_callback_returns() const { return missing_returns; }
+  };
+}
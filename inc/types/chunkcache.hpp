@@ -0,0 +1,69 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "lua/lua.hpp"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief On-disk cache of compiled Lua chunks. Entries are keyed by a hash of the source, its chunk name,
+   * the engine version and the Lua version, and hold `lua_dump` output behind a validated header.
+   * Loading a hit skips the Lua parser. A stale, foreign or corrupted entry is ignored and rewritten.
+   * @note The directory must be trusted: Lua does not verify bytecode, the header only guards against corruption.
+   * Thread-safe: one cache may be shared by many States.
+   */
+  class ChunkCache {
+  private:
+    std::string directory;
+
+    std::atomic<uint64_t> hits   = 0;
+    std::atomic<uint64_t> misses = 0;
+
+    std::string entry_path(uint64_t key) const;
+    bool        load_entry(lua_State *L, const std::string &path, uint64_t hash, uint64_t length);
+    void        store_entry(lua_State *L, const std::string &path, uint64_t hash, uint64_t length);
+
+  public:
+    /** @brief Uses `directory` to store the entries. It must exist. */
+    ChunkCache(const std::string &directory);
+
+    /**
+     * @brief Pushes the compiled chunk of `source` onto the stack, like luaL_loadbufferx with `chunkname`.
+     * @return A Lua status. On error, the error message is pushed instead.
+     */
+    int load(lua_State *L, const char *source, size_t length, const char *chunkname);
+
+    /** @brief Count of loads served from the cache. */
+    uint64_t hit_count() const;
+
+    /** @brief Count of loads that had to compile. */
+    uint64_t miss_count() const;
+
+    /** @brief 64-bit hash used for keys and checks. */
+    static uint64_t hash(const void *data, size_t length, uint64_t seed);
+  };
+}
@@ -0,0 +1,99 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "state.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief Collects garbage of many States on background threads, while they are idle.
+   * Every period, each State that grew by more than a threshold since its last completed cycle gets a time-boxed
+   * run of collector steps. A State the host is using is skipped, and a call arriving during a collection asks it
+   * to stop and waits at most one basic step: the collection hands the State back.
+   * @note States must be added and removed while idle, from the thread that uses them, and outside of their callbacks.
+   * A State destroyed while scheduled removes itself. Every other State must be removed before the scheduler is destroyed.
+   * @warning Finalizers (`__gc` metamethods) run by a collection, and the host callbacks they call, run on the
+   * scheduler's threads, while the thread using the State waits for the collection to finish.
+   */
+  class GcScheduler {
+  private:
+    struct entry {
+      State *state;
+      bool   took_over;
+    };
+
+    std::vector<entry>       states;
+    std::mutex               states_lock;
+    uint64_t                 cursor = 0;
+
+    std::vector<std::thread> threads;
+    std::atomic<bool>        stopping = false;
+    std::mutex               sleep_lock;
+    std::condition_variable  wake;
+
+    uint64_t nthreads;
+    uint64_t period_us;
+    uint64_t budget_us;
+    uint64_t threshold;
+
+    void run();
+
+    /** @brief Locks the next State to visit. nullptr when there is none. */
+    State *next(std::unique_lock<std::mutex> &handoff);
+
+  public:
+    /**
+     * @brief Starts the scheduler.
+     * @param nthreads Count of collecting threads. Zero means one.
+     * @param period_us How often States are visited.
+     * @param budget_us Longest collection of one State per visit.
+     * @param threshold Heap growth, in bytes, below which a State is left alone.
+     */
+    GcScheduler(uint64_t nthreads, uint64_t period_us, uint64_t budget_us, uint64_t threshold);
+
+    /** @brief Stops the threads. Every State must have been removed (see remove). */
+    ~GcScheduler();
+
+    GcScheduler(const GcScheduler&) = delete;
+    GcScheduler &operator=(const GcScheduler&) = delete;
+
+    /**
+     * @brief Schedules a State. A State is in one scheduler at most: adding it again does nothing.
+     * @param take_over Stops the State's own allocation-driven collection, so that its calls never collect.
+     * Its heap then only shrinks when the scheduler (or the host) collects.
+     */
+    void add(State &state, bool take_over = false);
+
+    /** @brief Unschedules a State, waiting for a collection of it to stop. A taken over State gets its own collection back. */
+    void remove(State &state);
+  };
+}
+
+using YumGcScheduler = YumEngine::xV1::GcScheduler;
@@ -0,0 +1,69 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "lua/lua.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief Samples of Lua stacks taken by the profiler of a State, aggregated by stack.
+   * Frames are named `function@source:line`, `?` standing for functions without a known name.
+   */
+  class Profiler {
+  public:
+    /** @brief A function, with its sample counts. See profentry_t. */
+    struct entry {
+      std::string frame;
+      uint64_t    self;
+      uint64_t    total;
+    };
+
+    /** @brief Deepest stack sampled. Deeper frames are dropped, from the root. */
+    static constexpr int max_depth = 64;
+
+  private:
+    std::unordered_map<std::string, uint64_t> stacks; // Folded stack (root first) -> samples.
+    uint64_t                                  samples = 0;
+
+  public:
+    /** @brief Records the stack of `L`. */
+    void sample(lua_State *L);
+
+    /** @brief Count of samples taken. */
+    inline uint64_t sample_count() const { return samples; }
+
+    /** @brief Stacks in the folded format of flame graph tools: `root;caller;callee count` per line. */
+    std::string folded() const;
+
+    /** @brief The `n` functions with the most samples of their own, most sampled first. */
+    std::vector<entry> top(uint64_t n) const;
+
+    /** @brief Forgets the samples taken. */
+    void reset();
+  };
+}
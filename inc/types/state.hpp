@@ -28,31 +28,421 @@
 #include "base/types.h"
 #include "base/callbacks.h"
 #include "system/err.h"
+#include "allocator.hpp"
+#include "archive.hpp"
+#include "chunkcache.hpp"
+#include "profiler.hpp"
+#include "callstats.hpp"
+#include "calltrace.hpp"
+#include "system/mappedfile.hpp"
 
 #include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
 namespace YumEngine::xV1 {
   /** @brief Represents a Yum callback. Takes an array of variant as input, and returns an array of variant. */
   using yum_callback = yumlibc_callback_type;
 
+  /** @brief Represents a Yum callback receiving the context pointer given when it was pushed. */
+  using yum_ctxcallback = yumlibc_ctxcallback_type;
+
+  /** @brief Represents an allocation-free Yum callback, see yumlibc_fastcallback_type. */
+  using yum_fastcallback = yumlibc_fastcallback_type;
+
+  class StateTemplate;
+  class GcScheduler;
+
   class State {
   private:
+    friend class StateTemplate;
+    friend class GcScheduler;
+    friend class CallReplay;
+
+    /** @brief Set when the State was created with an allocator policy. Outlives `L`. */
+    std::unique_ptr<Allocator> allocator;
+
     lua_State *L;
 
+    /** @brief Reusable memory for tables given to visitors, one per nesting level of visiting calls. */
+    std::vector<std::unique_ptr<std::vector<char>>> scratches;
+    uint64_t                                        visit_depth = 0;
+
+    /** @brief Registry references of emptied tables, to pin the values of the next borrowing calls. */
+    std::vector<int> free_pins;
+
+    /** @brief A host callback pushed to this State. Lua closures refer to it by index and generation. */
+    struct callback_slot {
+      yum_callback     callback;
+      yum_ctxcallback  ctxcallback;
+      yum_fastcallback fastcallback;
+      void            *context;
+      uint32_t         generation;
+    };
+
+    std::vector<callback_slot> callbacks;
+    std::vector<std::string>   callback_names; // By slot, for call stats. Kept apart so dispatching copies no string.
+    std::vector<uint64_t>      free_callbacks;
+
+    /** @brief Engine-owned buffers of allocation-free callbacks, one per nesting level. Grown once, then reused. */
+    struct callback_frame {
+      std::vector<variant_t> arguments;
+      std::vector<char>      tables;
+      std::vector<variant_t> values;
+      std::vector<char>      arena;
+    };
+
+    std::vector<std::unique_ptr<callback_frame>> callback_frames;
+    uint64_t                                     callback_depth = 0;
+
+    /** @brief Bytecode cache used by run and load, if any. */
+    std::shared_ptr<ChunkCache> chunk_cache;
+
+    /** @brief Compiles a chunk, through the bytecode cache when there is one. */
+    int load_chunk(const char *source, size_t length, const char *chunkname);
+
+    /** @brief Hint large pages when mapping script files. */
+    bool large_pages = false;
+
+    /** @brief Set once open_stdlibs was called. */
+    bool stdlibs = false;
+
+    gcstats_t gc_counters = {};
+
+    /** @brief Set by gc_mode. A generational step is a whole young collection, which Lua never reports as a finished cycle. */
+    bool gc_generational = false;
+
+    /** @brief Accounts a host-driven collection of `ns` nanoseconds that freed `freed` bytes, and traces it as `what`. */
+    void gc_account(const char *what, uint64_t ns, uint64_t freed);
+
+    /** @brief Lua heap size, in bytes. */
+    uint64_t heap_bytes() const;
+
+    /** @brief Held by a GcScheduler while it collects, and by the host while it uses a scheduled State. */
+    mutable std::mutex        gc_handoff;
+    mutable std::atomic<bool> gc_handoff_requested = false;
+    std::atomic<bool>         gc_scheduled = false;
+    GcScheduler              *gc_scheduler = nullptr; // Set and cleared by the thread using the State.
+    mutable uint32_t          busy_depth = 0;
+    uint64_t                  gc_baseline = 0;
+
+    /** @brief The State a background collection runs on, on this thread. Its finalizers may re-enter it. */
+    static inline thread_local const State *collecting = nullptr;
+
+    /**
+     * @brief Marks the State busy for the duration of a public call. When a GcScheduler collects this State,
+     * asks it to stop and waits for it. Nested calls (from callbacks) only count.
+     * Calls made by finalizers during a background collection run on the collecting thread, which holds the State.
+     */
+    struct busy_scope {
+      const State *state;
+      bool         locked = false;
+      bool         collected = false; // Within a background collection: neither counted nor locked.
+
+      inline busy_scope(const State *state) : state(state) {
+        bool scheduled = state->gc_scheduled.load(std::memory_order_acquire);
+        if (scheduled && collecting == state) [[unlikely]] {
+          collected = true;
+          return;
+        }
+
+        if (state->busy_depth++ == 0) {
+          // An interrupt aims at the calls running when it arrives, not at the next ones.
+          state->interrupt_requested.store(false, std::memory_order_relaxed);
+
+          if (scheduled) {
+            state->gc_handoff_requested.store(true, std::memory_order_relaxed);
+            state->gc_handoff.lock();
+            state->gc_handoff_requested.store(false, std::memory_order_relaxed);
+            locked = true;
+          }
+        }
+      }
+
+      inline ~busy_scope() {
+        if (collected) return;
+        if (--state->busy_depth == 0 && locked) state->gc_handoff.unlock();
+      }
+    };
+
+    /**
+     * @brief Collects from a GcScheduler thread, holding `gc_handoff`, if the State grew by `threshold` bytes
+     * since its last completed cycle, or its last young collection in generational mode. Stops after `budget_us`,
+     * at the end of a cycle (after one step in generational mode), or as soon as the host
+     * needs the State. Finalizers run on the calling thread meanwhile.
+     * @return true if collection ran.
+     */
+    bool gc_background(uint64_t budget_us, uint64_t threshold);
+
+    /** @brief A call running on a pooled coroutine. */
+    struct task_slot {
+      lua_State  *thread = nullptr;
+      int         ref = LUA_NOREF;
+      int         nargs = 0;     // Arguments waiting for the first resume.
+      bool        active = false;
+      uint32_t    generation = 0;
+      std::string what;
+    };
+
+    /** @brief A coroutine kept for later tasks, anchored in the registry. */
+    struct pooled_thread {
+      lua_State *thread;
+      int        ref;
+    };
+
+    /** @brief Instruction and time limits, checked by the count hook. */
+    struct hook_limit {
+      lua_State *thread;       // For slices, the task's coroutine.
+      uint64_t   instructions; // 0 for no limit.
+      uint64_t   executed;
+      uint64_t   deadline_ns;  // Steady clock, 0 for no limit.
+      int        count;        // Instructions between two hook calls.
+
+      hook_limit(lua_State *thread, uint64_t instructions, uint64_t time_us);
+
+      /** @brief Accounts one hook call, `count` instructions after the previous one. */
+      bool spent(int count);
+    };
+
+    std::vector<task_slot>     tasks;
+    std::vector<uint32_t>      free_tasks;
+    std::vector<pooled_thread> idle_threads;
+    hook_limit                *current_slice = nullptr;
+
+    callbudget_t              budget = {};
+    hook_limit               *active_budget = nullptr;
+    bool                      budget_tripped = false;
+    uint32_t                  call_depth = 0;
+    mutable std::atomic<bool> interrupt_requested = false; // Cleared when the host starts using the State.
+    std::atomic<lua_State*>   running_thread = nullptr;
+
+    Profiler                  profiler;
+    bool                      profiling = false;
+    profmode_t                profile_mode = YUM_PROFILE_INSTRUCTIONS;
+    uint64_t                  profile_period = 0;
+    int64_t                   profile_countdown = 0;
+    std::atomic<bool>         sample_due = false;
+    std::atomic<bool>         profile_timer_stop = false;
+    std::thread               profile_timer;
+
+    std::shared_ptr<CallStats>    stats;
+    std::shared_ptr<CallRecorder> recorder;
+    CallReplay                   *replay = nullptr; // Set while a log is replayed: callbacks return recorded values.
+
+    /** @brief Paths handles were resolved from, by function reference. For stats, traces and logs. */
+    std::unordered_map<int32_t, std::string> handle_paths;
+
+    /** @brief The path `handle` was resolved from. */
+    utf8 handle_path(const fnhandle_t &handle) const;
+
+    /** @brief Returns the values recorded for a callback, instead of calling it. */
+    static int replay_callback(lua_State *L, State *state, uint64_t index);
+
+    /**
+     * @brief Timestamps of a call into Lua, recorded in `stats`, the call log and the trace when it ends.
+     * Only taken while one of them is on.
+     */
+    struct call_record {
+      CallStats            *stats;
+      CallRecorder         *recorder;
+      std::string_view      name;
+      uint64_t              argc;
+      const variant_t      *args;
+      uint64_t              start = 0;
+      uint64_t              exec_start = 0;
+      uint64_t              exec_end = 0;
+      bool                  counting = false; // Whether `counted` holds the hardware counters read at the start.
+      PerfCounters::sample  counted;
+
+      call_record(State *state, std::string_view name, uint64_t argc, const variant_t *args);
+
+      /** @brief Marks the end of marshalling arguments, once the function and its arguments are pushed. */
+      void executing();
+
+      /** @brief Marks the return of the Lua function. What follows translates its returned values. */
+      void executed();
+
+      /** @brief Records the call, failed when it raised an error or its values could not be translated. */
+      void finish(bool failed);
+    };
+
+    /**
+     * @brief The count hook. Raises an error when the call budget is spent or an interrupt was requested,
+     * yields a task once its slice is spent, where yielding is allowed, and samples for the profiler.
+     * Only installed while one of them is set.
+     */
+    static void count_hook(lua_State *L, lua_Debug *ar);
+
+    /** @brief (Re)installs or removes the count hook of `thread`, for `limit` and the profiler. */
+    void rehook(lua_State *thread, const hook_limit *limit);
+
+    /** @brief Category of an error returned by pcall or lua_resume. */
+    decltype(syserr_t::category) failure_category(int status) const;
+
+    /** @brief Starts a task on the function at the top of the stack, then runs its first slice. */
+    syserr_t start_task(utf8 what, uint64_t argc, const variant_t* args, const timeslice_t &slice, taskhandle_t &task, boolean_t &done, uint64_t &nargs, variant_t **out);
+
+    /** @brief Gives the coroutine of a finished task back to the pool, and frees its slot. */
+    void finish_task(uint32_t index, bool reset);
+
+    /** @brief Mounted script archives, searched by `require` in mount order. */
+    std::vector<std::shared_ptr<Archive>> archives;
+
+    /** @brief package.searchers entry resolving modules from the mounted archives. */
+    static int archive_searcher(lua_State *L);
+
+    /** @brief Compiles a file, like luaL_loadfile, from a memory mapping and through the bytecode cache when there is one. */
+    int load_file(utf8 path);
+
+    /** @brief Runs an allocation-free callback. */
+    static int dispatch_fastcallback(lua_State *L, State *state, const callback_slot &slot, uint64_t index);
+
+    /** @brief lua_pcall, keeping host-side call state consistent when Lua unwinds. */
+    int pcall(int nargs, int nresults);
+
+    /** @brief The Lua closure of every host callback. Finds its slot from its upvalues, no lookup by name. */
+    static int dispatch_callback(lua_State *L);
+
+    uint64_t register_callback(utf8 name, const callback_slot &slot);
+
+    /** @brief Pushes the function of a handle, if the handle is still valid. Pushes nothing otherwise. */
+    bool     push_handle(const fnhandle_t &handle);
+
+    /** @brief Calls the function pushed above `top_before`, leaving its returned values on the stack. */
+    syserr_t execute(int top_before, utf8 what, uint64_t argc, const variant_t* args, call_record &record);
+
+    /** @brief Calls the function pushed above `top_before`, and translates its returned values. */
+    syserr_t invoke(int top_before, utf8 what, uint64_t argc, const variant_t* args, uint64_t& nargs, variant_t **out, call_record &record);
+
+    /** @brief Calls the function pushed above `top_before`, and translates its returned values into a frame. */
+    syserr_t invoke(int top_before, utf8 what, uint64_t argc, const variant_t* args, varframe_t &frame, call_record &record, yumlibc_framegrow_type grow, void *context);
+
+    /** @brief Calls the function at the top of the stack once per argument tuple. Pops the function. */
+    syserr_t invoke_batch(utf8 what, uint64_t count, uint64_t argc, const variant_t* args, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t& nfailed);
+
   public:
     /** @brief Initializes a new State. */
     State();
 
+    /**
+     * @brief Initializes a new State allocating through the given policy.
+     * @throws std::bad_alloc if Lua could not be created within the policy.
+     */
+    State(const allocpolicy_t &policy);
+
+    /**
+     * @brief Initializes a new State from a template, see State::capture().
+     * @throws sysexception if the template cannot be restored.
+     */
+    State(const StateTemplate &source);
+
+    /** @brief Initializes a new State from a template, allocating through the given policy. */
+    State(const StateTemplate &source, const allocpolicy_t &policy);
+
     /** @brief Destroys the current State. */
     ~State();
 
+    /**
+     * @brief Captures this State, once bootstrapped, into a template new States are created from.
+     * Globals and modules reachable from them are serialized into a compact image: tables (shared and cyclic ones
+     * included, with their metatables), scalars, light userdata, Lua functions as bytecode with their upvalues,
+     * C functions and host callbacks. Callbacks stay bound to the same host functions and contexts.
+     * @note Full userdata and coroutines are not captured; the standard libraries' own are recreated by
+     * open_stdlibs. Function handles, borrowed scopes and other registry references are not captured.
+     */
+    std::shared_ptr<const StateTemplate> capture();
+
+    /** 
+     * @brief Switches the collector mode, with Lua's default parameters.
+     * @note Switch modes with this rather than collectgarbage() from Lua, so that gc_step knows the mode.
+     */
+    void gc_mode(gcmode_t mode);
+
+    /**
+     * @brief Runs collector steps until `budget_us` microseconds are spent or a cycle completes.
+     * Meant to be called once per frame, in the frame's spare time. At least one step runs.
+     * In generational mode, runs a single young collection and counts it as a cycle.
+     * @return true if a cycle completed.
+     */
+    bool gc_step(uint64_t budget_us);
+
+    /** @brief Runs a full collection. */
+    void gc_collect();
+
+    /**
+     * @brief Stops automatic collection, e.g. around a latency-critical section. gc_step and gc_collect still work.
+     * @note The heap grows unbounded until gc_restart.
+     */
+    void gc_stop();
+
+    /** @brief Restarts automatic collection. */
+    void gc_restart();
+
+    /** @brief Whether automatic collection is running. */
+    bool gc_running() const;
+
+    /** @brief Counters of host-driven collections. */
+    gcstats_t gc_stats() const;
+
+    /** @brief Resets the counters of host-driven collections. */
+    void gc_reset_stats();
+
+    /**
+     * @brief Gives another context to a callback, typically in a State created from a template.
+     * @return false if `id` does not name a live callback taking a context.
+     */
+    bool rebind_callback(uint64_t id, void *context);
+
+    /**
+     * @brief Memory counters of this State.
+     * @note Without an allocator policy, only `live` and `peak` are known, from Lua's own count.
+     */
+    memstats_t memory_stats() const;
+
+    /**
+     * @brief Changes the hard memory cap. 0 for no cap.
+     * @return false when the State was not created with an allocator policy.
+     */
+    bool set_memory_limit(uint64_t limit);
+
     /** 
      * @brief Pushes a C-like callback to the State. 
      * @param name The name of the callback.
      * @param callback The callback that will get pushed.
+     * @return An id, to give to State::remove_callback().
+     * @note You may push a table before pushing a callback (or you will end with UBs!)
+     */
+    uint64_t push_callback(utf8 name, const yum_callback &callback);
+
+    /** 
+     * @brief Pushes a C-like callback to the State, with a context pointer given back on every call.
+     * @param name The name of the callback.
+     * @param callback The callback that will get pushed.
+     * @param context Given back to the callback. Not owned by the State.
+     * @return An id, to give to State::remove_callback().
+     * @note You may push a table before pushing a callback (or you will end with UBs!)
+     */
+    uint64_t push_callback(utf8 name, const yum_ctxcallback &callback, void *context);
+
+    /** 
+     * @brief Pushes an allocation-free callback to the State. Its arguments and results never touch the heap.
+     * @param name The name of the callback.
+     * @param callback The callback that will get pushed.
+     * @param context Given back to the callback. Not owned by the State.
+     * @return An id, to give to State::remove_callback().
      * @note You may push a table before pushing a callback (or you will end with UBs!)
      */
-    void push_callback(utf8 name, const yum_callback &callback);
+    uint64_t push_callback(utf8 name, const yum_fastcallback &callback, void *context);
+
+    /**
+     * @brief Removes a callback. Lua functions still referring to it raise an error when called.
+     * @param id An id given by State::push_callback().
+     */
+    void remove_callback(uint64_t id);
 
     /**
      * @brief Calls a Lua function.
@@ -66,6 +456,104 @@ namespace YumEngine::xV1 {
      */
     syserr_t call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, uint64_t& nargs, variant_t **out);
 
+    /**
+     * @brief Calls a Lua function, writing its returned values into a caller-owned frame. Allocates nothing.
+     * @param path The path of the function in a string (e.g. sometable.anotherone.funcname)
+     * @param pathlen Size of the path.
+     * @param argc Count of arguments.
+     * @param argv Arguments that you will give to the function.
+     * @param frame [Out] receives the returned values. Strings and binaries live in its arena.
+     * @param grow Called if the frame is too small, so the values still get converted into it. May be null.
+     * @param context Given to `grow`.
+     * @return BUFFER_OVERFLOW if the frame is too small and could not grow. The function has run anyway.
+     */
+    syserr_t call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, varframe_t &frame,
+                  yumlibc_framegrow_type grow = nullptr, void *context = nullptr);
+
+    /**
+     * @brief Calls a Lua function, borrowing its returned strings and binaries instead of copying them.
+     * @param path The path of the function in a string (e.g. sometable.anotherone.funcname)
+     * @param pathlen Size of the path.
+     * @param argc Count of arguments.
+     * @param argv Arguments that you will give to the function.
+     * @param frame [Out] receives the returned values. Strings and binaries have `owns == false`, the arena only holds tables.
+     * @param scope [Out] pins the returned values, and every string and binary borrowed from their tables.
+     *              Borrowed memory is valid until State::release(scope), even if Lua changes those tables meanwhile.
+     * @return BUFFER_OVERFLOW if the frame is too small, nothing is pinned then.
+     */
+    syserr_t call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, varframe_t &frame, callscope_t &scope);
+
+    /**
+     * @brief Calls a Lua function, and gives its returned values one by one to a visitor. Nothing is copied.
+     * @param path The path of the function in a string (e.g. sometable.anotherone.funcname)
+     * @param pathlen Size of the path.
+     * @param argc Count of arguments.
+     * @param argv Arguments that you will give to the function.
+     * @param visitor Receives the values. Borrowed strings and binaries are only valid during the visit.
+     * The visitor may call this State again, visitors included.
+     * @param context Given back to the visitor.
+     */
+    syserr_t call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, yumlibc_visitor_type visitor, void *context);
+
+    /**
+     * @brief Releases the values pinned by a borrowing call.
+     * @param scope A scope given by a borrowing State::call().
+     */
+    void release(callscope_t &scope);
+
+    /**
+     * @brief Resolves a Lua function once, so it can be called without walking its path again.
+     * @param path The path of the function (e.g. sometable.anotherone.funcname)
+     * @param pathlen Size of the path.
+     * @param handle [Out] the resolved handle. You may release it with State::release().
+     */
+    syserr_t resolve(utf8 path, uint64_t pathlen, fnhandle_t &handle);
+
+    /**
+     * @brief Calls a resolved Lua function.
+     * @param handle A handle given by State::resolve().
+     * @param argc Count of arguments.
+     * @param argv Arguments that you will give to the function.
+     * @param outc [Out] count of returned arguments.
+     * @param out [Out] output of the call.
+     * @return INVALID_HANDLE if the function or a table on its path got reassigned since it was resolved. Resolve it again.
+     */
+    syserr_t call(const fnhandle_t &handle, uint64_t argc, const variant_t* args, uint64_t& nargs, variant_t **out);
+
+    /**
+     * @brief Calls a resolved Lua function, writing its returned values into a caller-owned frame.
+     * @see State::call(utf8, uint64_t, uint64_t, const variant_t*, varframe_t&, yumlibc_framegrow_type, void*)
+     */
+    syserr_t call(const fnhandle_t &handle, uint64_t argc, const variant_t* args, varframe_t &frame,
+                  yumlibc_framegrow_type grow = nullptr, void *context = nullptr);
+
+    /**
+     * @brief Calls the same Lua function once per argument tuple, walking its path only once.
+     * @param path The path of the function (e.g. sometable.anotherone.funcname)
+     * @param pathlen Size of the path.
+     * @param count Count of calls (argument tuples).
+     * @param argc Count of arguments of each call.
+     * @param args `count * argc` arguments, tuple after tuple.
+     * @param outc Count of returned values kept per call. Missing values are NIL, extra ones are dropped.
+     * @param out [Out] `count * outc` values, written tuple after tuple. You may free them with yumfree_all().
+     * @param errors [Out] `count` errors, one per call. May be null.
+     * @param nfailed [Out] count of calls that failed. A failing call does not stop the batch, its values are NIL.
+     * @return An error only if the function could not be found. Per-call errors go to `errors`.
+     */
+    syserr_t call_batch(utf8 path, uint64_t pathlen, uint64_t count, uint64_t argc, const variant_t* args, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t& nfailed);
+
+    /**
+     * @brief Calls the same resolved Lua function once per argument tuple.
+     * @see State::call_batch(utf8, uint64_t, uint64_t, uint64_t, const variant_t*, uint64_t, variant_t*, syserr_t*, uint64_t&)
+     */
+    syserr_t call_batch(const fnhandle_t &handle, uint64_t count, uint64_t argc, const variant_t* args, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t& nfailed);
+
+    /**
+     * @brief Releases a resolved handle. The handle is invalid afterwards.
+     * @param handle A handle given by State::resolve().
+     */
+    void release(fnhandle_t &handle);
+
     /**
      * @brief Pushes a value.
      * @param name The name of value.
@@ -106,6 +594,106 @@ namespace YumEngine::xV1 {
      */
     syserr_t load(const lstring_t &source, boolean_t isfile);
 
+    /**
+     * @brief Calls a function on a pooled coroutine, running it for one slice. The host resumes it on later
+     * frames until it completes. Scripts may also end a slice early with coroutine.yield() (values yielded are dropped).
+     * @param path The path of the function (e.g. sometable.anotherone.funcname)
+     * @param slice Limits of the first slice.
+     * @param task Set to the handle of the task, if it did not complete.
+     * @param done Set to true once the call completed or failed. The task is then released.
+     * @param nargs Set to the count of returned values, once done.
+     * @param out Set to the returned values, once done. Free them with yumfree_array().
+     * @note A slice only ends where Lua may yield: not inside metamethods called from C, nor inside callbacks
+     * calling back into Lua. Tasks run on the thread the host calls resume from.
+     */
+    syserr_t call_async(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, const timeslice_t &slice, taskhandle_t &task, boolean_t &done, uint64_t& nargs, variant_t **out);
+
+    /** @brief Calls a resolved function asynchronously, see call_async(utf8...). */
+    syserr_t call_async(const fnhandle_t &handle, uint64_t argc, const variant_t* args, const timeslice_t &slice, taskhandle_t &task, boolean_t &done, uint64_t& nargs, variant_t **out);
+
+    /** @brief Runs a task for one more slice. Same outputs as call_async. */
+    syserr_t resume(const taskhandle_t &task, const timeslice_t &slice, boolean_t &done, uint64_t& nargs, variant_t **out);
+
+    /** @brief Abandons a task, closing its pending to-be-closed variables. */
+    void cancel(const taskhandle_t &task);
+
+    /**
+     * @brief Limits every following call (call, call_batch, run) in instructions and wall-clock time.
+     * Calls made by callbacks share the budget of the call they are part of. { 0, 0 } removes the limits.
+     * @note Costs nothing while no limit is set. Coroutines created before a call are not limited.
+     */
+    void set_call_budget(const callbudget_t &budget);
+
+    /** @brief The current call budget. */
+    callbudget_t call_budget() const;
+
+    /**
+     * @brief Aborts the running call (or task slice) with BUDGET_EXCEEDED. Safe from any thread, e.g. a watchdog.
+     * Also aborts a call still walking its path or converting its arguments, and every remaining item of a batch.
+     * Does nothing when the host is not using the State: the next call starts anew.
+     * @note Code running in a coroutine created before the interrupt is only stopped when it returns to its caller.
+     */
+    void interrupt();
+
+    /**
+     * @brief Starts sampling Lua stacks, every `period` instructions or microseconds. Restarts if already started.
+     * @note Time sampling runs a timer thread, and samples at the next hook call (at most 100 instructions later).
+     * Stacks of coroutines are sampled from the coroutine, without their resumer.
+     */
+    void start_profiler(profmode_t mode, uint64_t period);
+
+    /** @brief Stops sampling. Samples are kept until reset. */
+    void stop_profiler();
+
+    /** @brief Samples taken so far. Read it while the profiler is stopped, or from the State's thread. */
+    inline const Profiler &profile() const { return profiler; }
+
+    /** @brief Forgets the samples taken. */
+    void reset_profile();
+
+    /**
+     * @brief Records calls into Lua (call, call_batch) and host callbacks in `stats`, which other States may share.
+     * nullptr stops recording. Calls failing before Lua runs (unknown path, released handle) and tasks are not recorded.
+     * @note Costs a branch per call while no stats are used. Calls through handles are named by the path they were resolved from.
+     * Not to be called from a callback: calls already running record in the stats they started with.
+     */
+    void use_call_stats(std::shared_ptr<CallStats> stats);
+
+    /** @brief The stats calls are recorded in, if any. */
+    inline const std::shared_ptr<CallStats> &call_stats() const { return stats; }
+
+    /**
+     * @brief Logs setup, calls and callback returns to `recorder`, for CallReplay. nullptr stops logging.
+     * Set it on a fresh State, so the log holds the whole setup. Not to be called from a callback.
+     * @note Costs a branch per call while no recorder is set. Tasks are not logged.
+     */
+    void record_calls(std::shared_ptr<CallRecorder> recorder);
+
+    /** @brief The recorder calls are logged to, if any. */
+    inline const std::shared_ptr<CallRecorder> &call_recorder() const { return recorder; }
+
+    /**
+     * @brief Caches the bytecode of what run and load compile, in `directory`. nullptr disables the cache.
+     * @note Sources are still read to be hashed. Only the Lua parser is skipped on a hit.
+     */
+    void use_bytecode_cache(utf8 directory);
+
+    /** @brief Uses a bytecode cache shared with other States. nullptr disables the cache. */
+    void use_bytecode_cache(std::shared_ptr<ChunkCache> cache);
+
+    /**
+     * @brief Mounts a script archive (see Archive). `require` then finds its modules in memory, before looking
+     * up package.path. Archives mounted first win.
+     * @note The package library must be opened first. The archive stays mapped until the State is destroyed.
+     */
+    syserr_t mount_archive(utf8 path);
+
+    /**
+     * @brief Asks for large pages behind the mappings of script files read by run and load. Only a hint.
+     * @note Worth it for big generated data scripts. Linux honours it for file mappings only when configured to.
+     */
+    void use_large_pages(boolean_t enabled);
+
     /**
      * @brief Ensures a path. If a table does not exists, it creates the table.
      * @param path The path.
@@ -123,4 +711,5 @@ namespace YumEngine::xV1 {
   };
 }
 
-using YumState = YumEngine::xV1::State;
\ No newline at end of file
+using YumState = YumEngine::xV1::State;
+using YumStateTemplate = YumEngine::xV1::StateTemplate;
\ No newline at end of file
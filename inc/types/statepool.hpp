@@ -0,0 +1,157 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "state.hpp"
+#include "variant.h"
+#include "base/types.h"
+#include "system/err.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <latch>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace YumEngine::xV1 {
+  /** @brief Initializes a State of a pool (open libs, run scripts, push callbacks...). Runs on the State's worker thread. */
+  using pool_initializer = void (*)(State &state, void *context);
+
+  /** @brief Receives the result of a pooled call, on the worker thread. `out` is owned by the receiver (see yumfree_array). */
+  using pool_completion = void (*)(void *context, syserr_t err, uint64_t outc, variant_t *out);
+
+  /** @brief Result of a pooled call. Owns its values. */
+  class PoolResult {
+  public:
+    syserr_t   err    = {};
+    uint64_t   count  = 0;
+    variant_t *values = nullptr;
+
+    inline PoolResult() {}
+    inline PoolResult(const PoolResult&) = delete;
+    inline PoolResult(PoolResult &&from) : err(from.err), count(from.count), values(from.values) {
+      from.count = 0;
+      from.values = nullptr;
+    }
+
+    inline ~PoolResult() {
+      if (values) yumfree_array(values, count);
+    }
+  };
+
+  /**
+   * @brief Owns N identically initialized States, each bound to its own worker thread.
+   * Calls are queued on per-worker deques: a worker runs its own jobs first (newest first), then steals
+   * the oldest jobs of the others. Jobs submitted with an affinity key always run on the same worker,
+   * so related calls see the same Lua globals.
+   */
+  class StatePool {
+  public:
+    /** @brief Affinity of jobs that may run on any worker. */
+    static constexpr uint64_t no_affinity = UINT64_MAX;
+
+  private:
+    struct job {
+      std::string             path;
+      std::vector<variant_t>  args;
+      std::vector<char>       bytes; // Copied strings and binaries of `args`.
+      std::promise<PoolResult> promise;
+      pool_completion         completion = nullptr;
+      void                   *context = nullptr;
+    };
+
+    struct worker {
+      std::thread                      thread;
+      std::mutex                       lock;
+      std::condition_variable          wake;   // Waited on under `lock`.
+      bool                             asleep = false;
+      std::deque<std::unique_ptr<job>> jobs;   // May be stolen.
+      std::deque<std::unique_ptr<job>> pinned; // Affinity jobs, never stolen.
+      std::unique_ptr<State>           state;
+      std::exception_ptr               failure; // Thrown by the initializer.
+    };
+
+    std::vector<std::unique_ptr<worker>> workers;
+    std::atomic<uint64_t>                next = 0;
+    std::atomic<uint64_t>                stealable = 0; // Jobs in the `jobs` deques, which any worker may take.
+    std::atomic<uint64_t>                sleepers = 0;
+    std::atomic<bool>                    stopping = false;
+
+    void                 enqueue(std::unique_ptr<job> task, uint64_t affinity);
+    std::unique_ptr<job> take(uint64_t self);
+    void                 run(uint64_t self, pool_initializer initializer, void *context, std::latch &ready);
+    void                 execute(State &state, job &task);
+    void                 stop();
+
+    /** @brief Wakes a sleeping worker, `first` if it sleeps, for a stealable job. */
+    void                 wake_one(uint64_t first);
+
+    static std::unique_ptr<job> make_job(utf8 path, uint64_t argc, const variant_t *args);
+
+  public:
+    /**
+     * @brief Starts the pool.
+     * @param nthreads Count of workers, and of States. Zero means one per hardware thread.
+     * @param initializer Called once per State, on its worker, before it takes any job. May be null.
+     * @param context Given back to the initializer.
+     * @throws What an initializer threw, once every worker is stopped.
+     */
+    StatePool(uint64_t nthreads, pool_initializer initializer, void *context);
+
+    /** @brief Runs the queued jobs, then stops the workers and destroys their States. */
+    ~StatePool();
+
+    StatePool(const StatePool&) = delete;
+    StatePool &operator=(const StatePool&) = delete;
+
+    /** @brief Count of workers (and States). */
+    inline uint64_t size() const { return workers.size(); }
+
+    /**
+     * @brief Queues a call.
+     * @param path The path of the function (e.g. sometable.anotherone.funcname)
+     * @param argc Count of arguments.
+     * @param args Arguments. Strings and binaries are copied, tables and packed arrays must outlive the call.
+     * @param affinity Jobs sharing a key run on the same State. StatePool::no_affinity lets any worker run it.
+     * @return The future result of the call.
+     */
+    std::future<PoolResult> submit(utf8 path, uint64_t argc, const variant_t *args, uint64_t affinity = no_affinity);
+
+    /**
+     * @brief Queues a call, and gives its result to a completion callback.
+     * @see StatePool::submit(utf8, uint64_t, const variant_t*, uint64_t)
+     * @param completion Called on the worker thread once the call is done.
+     * @param context Given back to the completion callback.
+     */
+    void submit(utf8 path, uint64_t argc, const variant_t *args, uint64_t affinity, pool_completion completion, void *context);
+  };
+}
+
+using YumStatePool = YumEngine::xV1::StatePool;
@@ -0,0 +1,65 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include "state.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief A bootstrapped State frozen into a compact image, made by State::capture().
+   * New States are created from it instead of re-running their bootstrap: the standard libraries are opened,
+   * the image is replayed over them, and the callbacks, archives and bytecode cache are shared.
+   * Immutable once captured: many threads may create States from the same template.
+   * Full userdata and coroutines are left out silently: table entries holding them are dropped, and upvalues
+   * holding them come back as nil.
+   */
+  class StateTemplate {
+  private:
+    friend class State;
+
+    std::vector<State::callback_slot> callbacks;
+    std::vector<std::string>          callback_names;
+    std::vector<uint64_t>             free_callbacks;
+    std::vector<std::shared_ptr<Archive>> archives;
+    std::shared_ptr<ChunkCache>       chunk_cache;
+    bool                              large_pages = false;
+    bool                              stdlibs = false;
+
+    /** @brief Serialized values, see ystatetemplate.cpp. */
+    std::string              image;
+
+    /** @brief Distinct function prototypes, as lua_dump output. Closures of the same function share one. */
+    std::vector<std::string> prototypes;
+
+    static std::shared_ptr<const StateTemplate> capture(State &state);
+    void restore(State &state) const;
+
+  public:
+    /** @brief Size of the serialized image and prototypes, in bytes. */
+    uint64_t size() const;
+  };
+}
@@ -44,6 +44,10 @@ typedef struct {
     ILL_FUNCTION_PATH,
     PROMOTED_CXX_EXCEPTION,
     SDK_EXCEPTION,
+    INVALID_HANDLE,
+    BUFFER_OVERFLOW,
+    OUT_OF_MEMORY,
+    BUDGET_EXCEEDED,
   } category;
 
   struct {
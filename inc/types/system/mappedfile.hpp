@@ -0,0 +1,60 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief A whole file mapped read-only in memory. Empty files map to an empty view.
+   * Falls back to reading the file when the platform refuses the mapping.
+   */
+  class MappedFile {
+  private:
+    const char *start  = nullptr;
+    size_t      length = 0;
+    bool        mapped = false;
+    void       *handle = nullptr; // Windows mapping object.
+
+    void close();
+
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /**
+     * @brief Maps `path`, replacing what was mapped before.
+     * @param large_pages Asks the system to back the mapping with large pages. Only a hint.
+     * @return false if the file could not be opened or read.
+     */
+    bool open(const char *path, bool large_pages = false);
+
+    inline const char *data() const { return start; }
+    inline size_t      size() const { return length; }
+  };
+}
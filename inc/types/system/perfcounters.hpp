@@ -0,0 +1,63 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace YumEngine::xV1 {
+  /**
+   * @brief Hardware performance counters of the calling thread, through perf_event_open on Linux.
+   * Every thread opens its own group on its first read, counting user space only, and closes it when it exits.
+   * Elsewhere, or where the kernel refuses them (perf_event_paranoid, containers, VMs without a PMU), reads fail.
+   * @note A read is a system call, some hundreds of nanoseconds: counting around short calls dilates them.
+   */
+  class PerfCounters {
+  public:
+    enum counter_t : uint8_t {
+      CYCLES,
+      INSTRUCTIONS,
+      L1D_MISSES,    // L1 data cache read misses.
+      LLC_MISSES,    // Last level cache misses.
+      BRANCH_MISSES, // Mispredicted branches.
+    };
+
+    static constexpr int counter_count = 5;
+
+    /** @brief Counter values, indexed by counter_t. Counters the CPU lacks stay at 0. */
+    struct sample {
+      uint64_t values[counter_count];
+    };
+
+    /** @brief Reads the counters of the calling thread, opening them first if needed. false if they cannot be opened. */
+    static bool read(sample &out);
+
+    /** @brief Replaces `start` with what was counted since it was read. false, leaving `start`, if the read fails. */
+    static bool since(sample &start);
+
+    /** @brief Whether the calling thread can count: cycles at least. */
+    static bool available();
+
+    /** @brief Short name of a counter, as in `cycles`. */
+    static const char *name(counter_t counter);
+  };
+}
@@ -25,7 +25,17 @@
 
 #include "base/types.h"
 #include "base/vardef.h"
+#include "_byumlibc.h"
 
 #define VARIANT_ENABLED 1
 
+/** @brief Frees a table owning its memory, with everything it holds. Does nothing for tables that do not own it. */
+yumlibc_cfun void yumfree_table(vartable_t *table);
+
+/** @brief Frees the strings, binaries and tables owned by the variants. The array itself stays. */
+yumlibc_cfun void yumfree_all(variant_t *vars, uint64_t length);
+
+/** @brief Frees the strings, binaries and tables owned by the variants, and the array itself. */
+yumlibc_cfun void yumfree_array(variant_t *vars, uint64_t length);
+
 #endif // YUM_INCLUDE_GUARD_VARIANT_H
\ No newline at end of file
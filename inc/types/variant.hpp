@@ -25,6 +25,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <string>
+#include <algorithm>
 
 #include "base/types.h"
 #include "base/vardef.h"
@@ -61,6 +62,15 @@ namespace YumEngine::xV1 {
         case variant_t::VARIANT_BINARY:
           if (this->raw.hold.binary.owns) yumfree(this->raw.hold.binary.start);
           break;
+        case variant_t::VARIANT_TABLE:
+          if (this->raw.hold.table && this->raw.hold.table->owns) yumfree(this->raw.hold.table);
+          break;
+        case variant_t::VARIANT_INTEGER_ARRAY:
+          if (this->raw.hold.integers.owns) yumfree(this->raw.hold.integers.start);
+          break;
+        case variant_t::VARIANT_NUMBER_ARRAY:
+          if (this->raw.hold.numbers.owns) yumfree(this->raw.hold.numbers.start);
+          break;
         default:
           break;
       }
@@ -104,6 +114,21 @@ namespace YumEngine::xV1 {
       this->raw.type = this->raw.VARIANT_BINARY;
     }
 
+    inline CVariant(vartable_t *in) {
+      this->raw.hold.table = in;
+      this->raw.type = this->raw.VARIANT_TABLE;
+    }
+
+    inline CVariant(const intarray_t &in) {
+      this->raw.hold.integers = in;
+      this->raw.type = this->raw.VARIANT_INTEGER_ARRAY;
+    }
+
+    inline CVariant(const numarray_t &in) {
+      this->raw.hold.numbers = in;
+      this->raw.type = this->raw.VARIANT_NUMBER_ARRAY;
+    }
+
     CVariant &operator=(const integer_t &in) {
       on_type_changes();
       this->raw.hold.integer = in;
@@ -162,6 +187,14 @@ namespace YumEngine::xV1 {
           return binaries_are_equal(raw.hold.binary, left.raw.hold.binary);
         case variant_t::VARIANT_UID:
           return raw.hold.uid.bytes == left.raw.hold.uid.bytes;
+        case variant_t::VARIANT_TABLE:
+          return raw.hold.table == left.raw.hold.table; // Same table, not same content.
+        case variant_t::VARIANT_INTEGER_ARRAY:
+          return raw.hold.integers.length == left.raw.hold.integers.length
+              && std::equal(raw.hold.integers.start, raw.hold.integers.start + raw.hold.integers.length, left.raw.hold.integers.start);
+        case variant_t::VARIANT_NUMBER_ARRAY:
+          return raw.hold.numbers.length == left.raw.hold.numbers.length
+              && std::equal(raw.hold.numbers.start, raw.hold.numbers.start + raw.hold.numbers.length, left.raw.hold.numbers.start);
         default: return false;
       }
     }
@@ -196,6 +229,18 @@ namespace YumEngine::xV1 {
       return this->raw.hold.uid;
     }
 
+    inline const vartable_t *as_table() const {
+      return this->raw.hold.table;
+    }
+
+    inline intarray_t as_integers() const {
+      return this->raw.hold.integers;
+    }
+
+    inline numarray_t as_numbers() const {
+      return this->raw.hold.numbers;
+    }
+
     inline variant_t &c() { return this->raw; }
     inline const variant_t &c() const { return this->raw; }
 
@@ -218,6 +263,12 @@ namespace YumEngine::xV1 {
         case variant_t::VARIANT_UID: {
           return std::to_string(raw.hold.uid.bytes);
         }
+        case variant_t::VARIANT_TABLE:
+          return "<table>";
+        case variant_t::VARIANT_INTEGER_ARRAY:
+          return "<integer[" + std::to_string(raw.hold.integers.length) + "]>";
+        case variant_t::VARIANT_NUMBER_ARRAY:
+          return "<number[" + std::to_string(raw.hold.numbers.length) + "]>";
       }
 
       return "<unknown>";
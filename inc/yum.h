@@ -24,6 +24,9 @@
 #define YUM_INCLUDE_GUARD_LIBYUM_H
 
 #include "inc/api/ystatec.h"
+#include "inc/api/ystatepoolc.h"
+#include "inc/api/ygcschedulerc.h"
+#include "inc/api/ytracec.h"
 #include "inc/managers/lstring_utils.h"
 #include "inc/types/base/callbacks.h"
 #include "inc/types/base/types.h"
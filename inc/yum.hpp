@@ -33,6 +33,10 @@
 #include "inc/types/system/exception.hpp"
 #include "inc/types/variant.hpp"
 #include "inc/types/state.hpp"
+#include "inc/types/statepool.hpp"
+#include "inc/types/gcscheduler.hpp"
+#include "inc/debug/tracer.hpp"
+#include "inc/types/statetemplate.hpp"
 #include "inc/utils/ystringutils.hpp"
 #include "inc/version/engine_version.h"
 
@@ -34,25 +34,87 @@ namespace YumEngine::xV1::Sdk {
   /* Working on
    * class SdkState; */
 
-  containers::list<CVariant> SdkState::call(const StringView &name, const Buffer<CVariant> &buff) {
-    uint64_t nargs;
-    variant_t *out;
+  static containers::list<variant_t> unwrap_arguments(const Buffer<CVariant> &buff) {
     containers::list<variant_t> variants;
     variants.reserve(buff.length());
     buff.foreach([&variants](CVariant var) { variants.append(var.c()); });
+    return variants;
+  }
 
-    syserr_t err = mstate.call(name.utf8(), name.length(), variants.length(), variants.data(), nargs, &out);
-    
-    if (err.category != err.OK) yumlibcxx_make_exception_from(err);
-
+  static containers::list<CVariant> wrap_results(uint64_t nargs, variant_t *out) {
     containers::list<CVariant> cvars;
     cvars.reserve(nargs);
     containers::memoryslice<variant_t>(out, nargs, false)
               .foreach([&cvars](variant_t var) { cvars.append(var); });
-    
+
+    if (nargs > 0) yumfree((void*)out); // CVariants hold the strings now, only the array goes.
     return cvars;
   }
 
+  static_assert(sizeof(CVariant) == sizeof(variant_t), "CVariant must stay layout-compatible with variant_t");
+
+  /** @brief Views the arguments as C variants, without copying them. */
+  static const variant_t *view_arguments(const Buffer<CVariant> &buff) {
+    return reinterpret_cast<const variant_t*>(buff.head());
+  }
+
+  /** @brief Grows a Frame a call found too small, so the call converts its results into it instead of failing. */
+  static boolean_t grow_frame(void *context, varframe_t *raw) {
+    try {
+      static_cast<Frame*>(context)->reserve(raw->count, raw->arena_used);
+      return yumtrue;
+    } catch (...) {
+      return yumfalse;
+    }
+  }
+
+  containers::list<CVariant> SdkState::call(const StringView &name, const Buffer<CVariant> &buff) {
+    uint64_t nargs;
+    variant_t *out = nullptr;
+    containers::list<variant_t> variants = unwrap_arguments(buff);
+
+    syserr_t err = mstate.call(name.utf8(), name.length(), variants.length(), variants.data(), nargs, &out);
+    
+    if (err.category != err.OK) yumlibcxx_make_exception_from(err);
+
+    return wrap_results(nargs, out);
+  }
+
+  void SdkState::call(const StringView &name, const Buffer<CVariant> &buff, Frame &frame) {
+    syserr_t err = mstate.call(name.utf8(), name.length(), buff.length(), view_arguments(buff), frame.c(), grow_frame, &frame);
+    if (err.category != err.OK) yumlibcxx_make_exception_from(err);
+  }
+
+  fnhandle_t SdkState::resolve(const StringView &name) {
+    fnhandle_t handle;
+    syserr_t err = mstate.resolve(name.utf8(), name.length(), handle);
+
+    if (err.category != err.OK) yumlibcxx_make_exception_from(err);
+
+    return handle;
+  }
+
+  containers::list<CVariant> SdkState::call(const fnhandle_t &handle, const Buffer<CVariant> &buff) {
+    uint64_t nargs;
+    variant_t *out = nullptr;
+    containers::list<variant_t> variants = unwrap_arguments(buff);
+
+    syserr_t err = mstate.call(handle, variants.length(), variants.data(), nargs, &out);
+    
+    if (err.category != err.OK) yumlibcxx_make_exception_from(err);
+
+    return wrap_results(nargs, out);
+  }
+
+  void SdkState::call(const fnhandle_t &handle, const Buffer<CVariant> &buff, Frame &frame) {
+    syserr_t err = mstate.call(handle, buff.length(), view_arguments(buff), frame.c(), grow_frame, &frame);
+    if (err.category != err.OK) yumlibcxx_make_exception_from(err);
+  }
+
+  void SdkState::release(fnhandle_t &handle) {
+    mstate.release(handle);
+  }
+
   containers::list<CVariant> SdkState::call(const StringView &name) {
     return call(name, Buffer<CVariant>());
   }
@@ -74,6 +136,18 @@ namespace YumEngine::xV1::Sdk {
     mstate.push_callback(name.move().utf8(), callback);
   }
 
+  uint64_t SdkState::push_callback(const StringView &name, yum_ctxcallback callback, void *context) {
+    return mstate.push_callback(name.move().utf8(), callback, context);
+  }
+
+  uint64_t SdkState::push_callback(const StringView &name, yum_fastcallback callback, void *context) {
+    return mstate.push_callback(name.move().utf8(), callback, context);
+  }
+
+  void SdkState::remove_callback(uint64_t id) {
+    mstate.remove_callback(id);
+  }
+
   void SdkState::open_libs() {
     mstate.open_stdlibs();
   }
@@ -0,0 +1,156 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/allocator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace YumEngine::xV1 {
+  Allocator::Allocator(const allocpolicy_t &policy) 
+    : policy(policy) {
+    counters.limit = policy.limit;
+  }
+
+  Allocator::~Allocator() {
+    for (void *chunk : chunks) underlying(chunk, chunk_size, 0);
+    for (auto [block, size] : adopted) underlying(block, size, 0);
+  }
+
+  void *Allocator::underlying(void *ptr, size_t osize, size_t nsize) {
+    if (policy.alloc) return policy.alloc(policy.userdata, ptr, osize, nsize);
+
+    if (nsize == 0) {
+      free(ptr);
+      return nullptr;
+    }
+
+    return realloc(ptr, nsize);
+  }
+
+  void *Allocator::capped(void *ptr, size_t osize, size_t nsize) {
+    // Only growth may fail: Lua expects shrinking to always succeed.
+    if (nsize > osize && counters.limit && counters.reserved - osize + nsize > counters.limit) return nullptr;
+
+    void *block = underlying(ptr, osize, nsize);
+    if (block || nsize == 0) counters.reserved = counters.reserved - osize + nsize;
+    return block;
+  }
+
+  void *Allocator::pool_take(uint64_t cls) {
+    if (free_block *block = free_lists[cls]) {
+      free_lists[cls] = block->next;
+      return block;
+    }
+
+    uint64_t size = (cls + 1) * size_class_step;
+    if (!chunk_cursor || chunk_cursor + size > chunk_end) {
+      char *chunk = (char*)capped(nullptr, 0, chunk_size);
+      if (!chunk) return nullptr;
+
+      chunks.push_back(chunk);
+      chunk_cursor = chunk;
+      chunk_end = chunk + chunk_size;
+    }
+
+    void *block = chunk_cursor;
+    chunk_cursor += size;
+    return block;
+  }
+
+  void Allocator::pool_give(void *ptr, uint64_t cls) {
+    free_block *block = (free_block*)ptr;
+    block->next = free_lists[cls];
+    free_lists[cls] = block;
+  }
+
+  void *Allocator::resize(void *ptr, size_t osize, size_t nsize) {
+    if (!policy.pooled) return capped(ptr, osize, nsize);
+
+    bool was_pooled = ptr && pooled_size(osize);
+    bool is_pooled  = pooled_size(nsize);
+
+    if (nsize == 0) {
+      if (was_pooled) pool_give(ptr, class_of(osize));
+      else capped(ptr, osize, 0);
+      return nullptr;
+    }
+
+    if (was_pooled && is_pooled && class_of(osize) == class_of(nsize)) return ptr;
+    if (!was_pooled && !is_pooled) return capped(ptr, osize, nsize);
+
+    // Moving between a pool and the underlying allocator (or between pools).
+    void *block = is_pooled ? pool_take(class_of(nsize)) : capped(nullptr, 0, nsize);
+    if (!block) {
+      if (!ptr || nsize > osize) return nullptr;
+
+      // Shrinking must not fail, and the block fits already: it stays, and belongs to its new class from now on.
+      // An underlying block is released with the pools; should recording it fail, it outlives them.
+      if (!was_pooled) {
+        try { adopted.emplace_back(ptr, osize); } catch (...) {}
+      }
+      return ptr;
+    }
+
+    if (ptr) {
+      std::memcpy(block, ptr, std::min(osize, nsize));
+      if (was_pooled) pool_give(ptr, class_of(osize));
+      else capped(ptr, osize, 0);
+    }
+
+    return block;
+  }
+
+  void *Allocator::lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+    Allocator *self = (Allocator*)ud;
+    size_t old = ptr ? osize : 0; // Without a block, Lua gives the type of the new object in osize.
+
+    if (nsize == 0) {
+      if (ptr) {
+        self->resize(ptr, old, 0);
+        self->counters.live -= old;
+      }
+      return nullptr;
+    }
+
+    void *block = self->resize(ptr, old, nsize);
+    if (!block) {
+      self->counters.failures++;
+      return nullptr;
+    }
+
+    self->counters.live = self->counters.live - old + nsize;
+    self->counters.peak = std::max(self->counters.peak, self->counters.live);
+    if (!ptr) self->counters.allocations++;
+    return block;
+  }
+
+  memstats_t Allocator::stats() const {
+    return counters;
+  }
+
+  void Allocator::set_limit(uint64_t limit) {
+    policy.limit = limit;
+    counters.limit = limit;
+  }
+}
@@ -0,0 +1,211 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/archive.hpp"
+#include "inc/types/chunkcache.hpp"
+#include "inc/lua/lua.hpp"
+
+#include <bit>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+namespace YumEngine::xV1 {
+  namespace {
+    inline uint64_t name_hash(std::string_view name) {
+      return ChunkCache::hash(name.data(), name.size(), 0);
+    }
+
+    inline uint64_t align8(uint64_t offset) {
+      return (offset + 7) & ~(uint64_t)7;
+    }
+
+    int dump_writer(lua_State *, const void *p, size_t sz, void *ud) {
+      std::string *code = (std::string*)ud;
+      code->append((const char*)p, sz);
+      return 0;
+    }
+  }
+
+  bool Archive::open(const char *path, std::string &error) {
+    head = nullptr;
+    entries = nullptr;
+    buckets = nullptr;
+    this->path = path;
+
+    if (!file.open(path)) {
+      error = std::string("cannot open archive ") + path;
+      return false;
+    }
+
+    const char *base = file.data();
+    uint64_t size = file.size();
+
+    if (size < sizeof(header) || std::memcmp(base, magic, sizeof(magic)) != 0) {
+      error = std::string("not a YumEngine archive: ") + path;
+      return false;
+    }
+
+    const header *h = (const header*)base;
+    bool valid = std::has_single_bit(h->bucket_count)
+      && h->count <= h->bucket_count
+      && h->entries_offset % 8 == 0 && h->buckets_offset % 8 == 0
+      && h->entries_offset <= size && (size - h->entries_offset) / sizeof(entry) >= h->count
+      && h->buckets_offset <= size && (size - h->buckets_offset) / sizeof(uint32_t) >= h->bucket_count;
+
+    const entry *e = (const entry*)(base + h->entries_offset);
+    for (uint32_t i = 0; valid && i < h->count; i++) {
+      valid = e[i].name_offset <= size && e[i].name_length <= size - e[i].name_offset
+        && e[i].chunk_offset <= size && e[i].chunk_length <= size - e[i].chunk_offset;
+    }
+
+    const uint32_t *b = (const uint32_t*)(base + h->buckets_offset);
+    for (uint32_t i = 0; valid && i < h->bucket_count; i++) {
+      valid = b[i] <= h->count;
+    }
+
+    if (!valid) {
+      error = std::string("corrupted YumEngine archive: ") + path;
+      return false;
+    }
+
+    head = h;
+    entries = e;
+    buckets = b;
+    return true;
+  }
+
+  const Archive::entry *Archive::find(std::string_view name) const {
+    if (!head || head->count == 0) return nullptr;
+
+    uint64_t hash = name_hash(name);
+    uint32_t mask = head->bucket_count - 1;
+
+    for (uint32_t i = (uint32_t)hash & mask, probes = 0; probes < head->bucket_count; i = (i + 1) & mask, probes++) {
+      uint32_t slot = buckets[i];
+      if (slot == 0) return nullptr;
+
+      const entry &e = entries[slot - 1];
+      if (e.hash == hash && this->name(e) == name) return &e;
+    }
+
+    return nullptr;
+  }
+
+  bool Archive::write(const char *path, const std::vector<source> &sources, bool precompile, std::string &error) {
+    std::vector<std::string> chunks;
+    chunks.reserve(sources.size());
+
+    std::unordered_set<std::string_view> names;
+    lua_State *L = precompile ? luaL_newstate() : nullptr;
+
+    for (const source &s : sources) {
+      if (!names.insert(s.name).second) {
+        error = "module packed twice: " + s.name;
+        if (L) lua_close(L);
+        return false;
+      }
+
+      if (!L) {
+        chunks.push_back(s.chunk);
+        continue;
+      }
+
+      std::string chunkname = "=" + s.name;
+      std::string code;
+
+      if (luaL_loadbufferx(L, s.chunk.data(), s.chunk.size(), chunkname.c_str(), "t") != LUA_OK) {
+        error = lua_tostring(L, -1);
+        lua_close(L);
+        return false;
+      }
+
+      lua_dump(L, dump_writer, &code, 0);
+      lua_pop(L, 1);
+      chunks.push_back(std::move(code));
+    }
+
+    if (L) lua_close(L);
+
+    // Index at most half full, so that probes stay short.
+    uint32_t count = (uint32_t)sources.size();
+    uint32_t bucket_count = std::bit_ceil(std::max<uint32_t>(count * 2, 1));
+
+    header h = {};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.count = count;
+    h.bucket_count = bucket_count;
+    h.entries_offset = align8(sizeof(header));
+    h.buckets_offset = align8(h.entries_offset + sizeof(entry) * count);
+
+    std::vector<entry>    table(count);
+    std::vector<uint32_t> slots(bucket_count, 0);
+    uint64_t              offset = align8(h.buckets_offset + sizeof(uint32_t) * bucket_count);
+
+    for (uint32_t i = 0; i < count; i++) {
+      entry &e = table[i];
+      e.hash = name_hash(sources[i].name);
+      e.name_offset = offset;
+      e.name_length = (uint32_t)sources[i].name.size();
+      e.chunk_offset = offset + e.name_length;
+      e.chunk_length = chunks[i].size();
+      e.flags = precompile ? bytecode : 0;
+      offset = align8(e.chunk_offset + e.chunk_length);
+
+      uint32_t b = (uint32_t)e.hash & (bucket_count - 1);
+      while (slots[b] != 0) b = (b + 1) & (bucket_count - 1);
+      slots[b] = i + 1;
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+      error = std::string("cannot write archive ") + path;
+      return false;
+    }
+
+    static const char padding[8] = {};
+    uint64_t written = 0;
+    auto put = [&](const void *data, uint64_t size) {
+      if (size && fwrite(data, 1, size, out) != size) return false;
+      written += size;
+      return true;
+    };
+    auto pad = [&]() { return put(padding, align8(written) - written); };
+
+    bool ok = put(&h, sizeof(h)) && pad()
+      && put(table.data(), sizeof(entry) * count) && pad()
+      && put(slots.data(), sizeof(uint32_t) * bucket_count) && pad();
+
+    for (uint32_t i = 0; ok && i < count; i++) {
+      ok = put(sources[i].name.data(), sources[i].name.size()) && put(chunks[i].data(), chunks[i].size()) && pad();
+    }
+
+    if (fclose(out) != 0 || !ok) {
+      remove(path);
+      error = std::string("cannot write archive ") + path;
+      return false;
+    }
+
+    return true;
+  }
+}
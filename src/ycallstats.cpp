@@ -0,0 +1,158 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/callstats.hpp"
+
+#include <map>
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+namespace YumEngine::xV1 {
+  namespace {
+    std::atomic<uint64_t> next_id = 1;
+
+    // Counters have a single writer: plain loads and stores are enough, and cost no locked instruction.
+    inline void bump(std::atomic<uint64_t> &counter, uint64_t value) {
+      counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+  }
+
+  CallStats::CallStats() : id(next_id.fetch_add(1)) {}
+
+  CallStats::shard &CallStats::local() {
+    // Keyed by id rather than address: a CallStats allocated where a destroyed one was must not find its shards.
+    thread_local uint64_t                               last_id = 0;
+    thread_local shard                                 *last = nullptr;
+    thread_local std::unordered_map<uint64_t, shard*>   owned;
+
+    if (last_id == id) return *last;
+
+    shard *&found = owned[id];
+    if (!found) {
+      std::lock_guard<std::mutex> guard(shards_lock);
+      shards.push_back(std::make_unique<shard>());
+      found = shards.back().get();
+    }
+
+    last_id = id;
+    last = found;
+    return *found;
+  }
+
+  void CallStats::record(kind_t kind, std::string_view name, bool failed, uint64_t marshal_ns, uint64_t exec_ns, 
+                         const PerfCounters::sample *counted) {
+    shard &own = local();
+    name_map &names = own.names[kind];
+
+    auto it = names.find(name);
+    if (it == names.end()) {
+      std::lock_guard<std::mutex> guard(own.lock);
+      it = names.emplace(std::string(name), std::make_unique<counters>()).first;
+    }
+
+    counters &c = *it->second;
+    uint64_t total = marshal_ns + exec_ns;
+
+    bump(c.calls, 1);
+    if (failed) bump(c.errors, 1);
+    bump(c.marshal_ns, marshal_ns);
+    bump(c.exec_ns, exec_ns);
+    bump(c.histogram[bucket_of(total)], 1);
+    if (total > c.max_ns.load(std::memory_order_relaxed)) c.max_ns.store(total, std::memory_order_relaxed);
+
+    if (counted) {
+      bump(c.counted, 1);
+      for (int i = 0; i < PerfCounters::counter_count; i++) bump(c.hardware[i], counted->values[i]);
+    }
+  }
+
+  std::vector<CallStats::entry> CallStats::snapshot() const {
+    std::map<std::pair<kind_t, std::string_view>, entry> merged;
+
+    std::lock_guard<std::mutex> guard(shards_lock);
+    for (const auto &own : shards) {
+      std::lock_guard<std::mutex> names_guard(own->lock);
+
+      for (int kind = LUA_PATH; kind <= HOST_CALLBACK; kind++) {
+        for (const auto &[name, c] : own->names[kind]) {
+          entry &e = merged[{ (kind_t)kind, name }];
+          if (e.histogram.empty()) {
+            e.name = name;
+            e.kind = (kind_t)kind;
+            e.histogram.resize(bucket_count);
+          }
+
+          e.calls      += c->calls.load(std::memory_order_relaxed);
+          e.errors     += c->errors.load(std::memory_order_relaxed);
+          e.marshal_ns += c->marshal_ns.load(std::memory_order_relaxed);
+          e.exec_ns    += c->exec_ns.load(std::memory_order_relaxed);
+          e.max_ns      = std::max(e.max_ns, c->max_ns.load(std::memory_order_relaxed));
+          for (int i = 0; i < bucket_count; i++) e.histogram[i] += c->histogram[i].load(std::memory_order_relaxed);
+          e.counted    += c->counted.load(std::memory_order_relaxed);
+          for (int i = 0; i < PerfCounters::counter_count; i++) e.hardware[i] += c->hardware[i].load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    std::vector<entry> entries;
+    entries.reserve(merged.size());
+    for (auto &[key, e] : merged) entries.push_back(std::move(e));
+    return entries;
+  }
+
+  uint64_t CallStats::entry::percentile(double q) const {
+    // Counters are read one by one while written: the histogram may hold a few calls more or less than `calls`.
+    uint64_t recorded = 0;
+    for (uint64_t count : histogram) recorded += count;
+    if (!recorded) return 0;
+
+    uint64_t rank = (uint64_t)std::ceil(std::clamp(q, 0.0, 1.0) * (double)recorded);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < (int)histogram.size(); i++) {
+      seen += histogram[i];
+      if (seen >= rank) return std::min(bucket_limit(i), max_ns);
+    }
+
+    return max_ns;
+  }
+
+  int CallStats::bucket_of(uint64_t ns) {
+    if (ns < (uint64_t)sub_buckets) return (int)ns;
+
+    int exponent = std::bit_width(ns) - 1;
+    if (exponent >= max_exponent) return bucket_count - 1;
+
+    int sub = (int)((ns >> (exponent - 3)) & (sub_buckets - 1));
+    return sub_buckets + (exponent - 3) * sub_buckets + sub;
+  }
+
+  uint64_t CallStats::bucket_limit(int bucket) {
+    if (bucket < sub_buckets) return (uint64_t)bucket;
+
+    int exponent = (bucket - sub_buckets) / sub_buckets + 3;
+    uint64_t sub = (uint64_t)((bucket - sub_buckets) % sub_buckets);
+    return ((sub_buckets + sub) << (exponent - 3)) + ((uint64_t)1 << (exponent - 3)) - 1;
+  }
+}
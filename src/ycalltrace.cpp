@@ -0,0 +1,491 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/calltrace.hpp"
+#include "inc/types/state.hpp"
+#include "inc/debug/tracer.hpp"
+#include "inc/version/engine_version.h"
+#include "inc/types/system/mappedfile.hpp"
+
+#include <map>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+namespace YumEngine::xV1 {
+  namespace {
+    constexpr size_t flush_threshold = 64 * 1024;
+    constexpr int    max_table_depth = 32;
+
+    boolean_t replay_stub(void *, uint64_t, const variant_t*, varframe_t *out) {
+      out->count = 0;
+      return true;
+    }
+
+    boolean_t discard_results(void *, uint64_t, const variant_t*) {
+      return false;
+    }
+  }
+
+  CallRecorder::~CallRecorder() {
+    close();
+  }
+
+  bool CallRecorder::open(utf8 path, std::string &error) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (file) {
+      flush_locked();
+      std::fclose(file);
+    }
+
+    file = std::fopen(path, "wb");
+    if (!file) {
+      error = std::string("cannot open ") + path + ": " + std::strerror(errno);
+      return false;
+    }
+
+    buffer.clear();
+    origin_ns = Tracer::now();
+    put(magic, sizeof(magic));
+    put_u32(version);
+    put_u32((uint32_t)YUM_ENGINE_VERSION_INT);
+    return true;
+  }
+
+  void CallRecorder::flush() {
+    std::lock_guard<std::mutex> guard(lock);
+    flush_locked();
+  }
+
+  void CallRecorder::close() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file) return;
+
+    flush_locked();
+    std::fclose(file);
+    file = nullptr;
+  }
+
+  void CallRecorder::flush_locked() {
+    if (file && !buffer.empty()) {
+      std::fwrite(buffer.data(), 1, buffer.size(), file);
+      std::fflush(file);
+    }
+    buffer.clear();
+  }
+
+  void CallRecorder::begin(op_t op) {
+    put_u8(op);
+    uint64_t now = Tracer::now();
+    put_u64(now > origin_ns ? now - origin_ns : 0);
+  }
+
+  void CallRecorder::put(const void *data, size_t length) {
+    const char *bytes = (const char*)data;
+    buffer.insert(buffer.end(), bytes, bytes + length);
+  }
+
+  void CallRecorder::put_u8(uint8_t value)   { put(&value, sizeof(value)); }
+  void CallRecorder::put_u32(uint32_t value) { put(&value, sizeof(value)); }
+  void CallRecorder::put_u64(uint64_t value) { put(&value, sizeof(value)); }
+
+  void CallRecorder::put_text(std::string_view text) {
+    put_u32((uint32_t)text.size());
+    put(text.data(), text.size());
+    put_u8(0); // Replayed names are given to APIs taking C strings.
+  }
+
+  void CallRecorder::put_variant(const variant_t &value) {
+    put_u8((uint8_t)value.type);
+
+    switch (value.type) {
+      case variant_t::VARIANT_INTEGER: put(&value.hold.integer, sizeof(integer_t)); break;
+      case variant_t::VARIANT_NUMBER:  put(&value.hold.number, sizeof(number_t)); break;
+      case variant_t::VARIANT_BOOL:    put_u8(value.hold.boolean ? 1 : 0); break;
+      case variant_t::VARIANT_UID:     put_u64(value.hold.uid.bytes); break;
+      case variant_t::VARIANT_STRING:  
+        put_u64(value.hold.lstring.length);
+        put(value.hold.lstring.start, value.hold.lstring.length);
+        break;
+      case variant_t::VARIANT_BINARY:
+        put_u64(value.hold.binary.length);
+        put(value.hold.binary.start, value.hold.binary.length);
+        break;
+      case variant_t::VARIANT_INTEGER_ARRAY:
+        put_u64(value.hold.integers.length);
+        put(value.hold.integers.start, value.hold.integers.length * sizeof(integer_t));
+        break;
+      case variant_t::VARIANT_NUMBER_ARRAY:
+        put_u64(value.hold.numbers.length);
+        put(value.hold.numbers.start, value.hold.numbers.length * sizeof(number_t));
+        break;
+      case variant_t::VARIANT_TABLE: {
+        const vartable_t *table = value.hold.table;
+        put_u8(table && table->keys ? 1 : 0);
+        put_u64(table ? table->length : 0);
+        for (uint64_t i = 0; table && i < table->length; i++) {
+          if (table->keys) put_variant(table->keys[i]);
+          put_variant(table->values[i]);
+        }
+        break;
+      }
+      default: break;
+    }
+  }
+
+  void CallRecorder::text(op_t op, std::string_view text) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file) return;
+
+    begin(op);
+    put_text(text);
+    if (buffer.size() >= flush_threshold) flush_locked();
+  }
+
+  void CallRecorder::push(std::string_view name, const variant_t &value) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file) return;
+
+    begin(PUSH);
+    put_text(name);
+    put_variant(value);
+    if (buffer.size() >= flush_threshold) flush_locked();
+  }
+
+  void CallRecorder::source(op_t op, std::string_view source, bool isfile) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file) return;
+
+    begin(op);
+    put_u8(isfile ? 1 : 0);
+    put_text(source);
+    if (buffer.size() >= flush_threshold) flush_locked();
+  }
+
+  void CallRecorder::call(std::string_view path, uint64_t argc, const variant_t *args, uint64_t start_ns, uint64_t duration_ns, bool failed) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file) return;
+
+    // Calls are logged once finished: they start before what they caused (callback returns).
+    begin(CALL);
+    put_u64(start_ns > origin_ns ? start_ns - origin_ns : 0);
+    put_u64(duration_ns);
+    put_u8(failed ? 1 : 0);
+    put_text(path);
+    put_u32((uint32_t)argc);
+    for (uint64_t i = 0; i < argc; i++) put_variant(args[i]);
+    if (buffer.size() >= flush_threshold) flush_locked();
+  }
+
+  void CallRecorder::callback_return(std::string_view name, uint64_t count, const variant_t *values) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!file) return;
+
+    begin(RETURN);
+    put_text(name);
+    put_u32((uint32_t)count);
+    for (uint64_t i = 0; i < count; i++) put_variant(values[i]);
+    if (buffer.size() >= flush_threshold) flush_locked();
+  }
+
+  bool CallReplay::open(utf8 path, std::string &error) {
+    MappedFile file;
+    if (!file.open(path, false)) {
+      error = std::string("cannot read ") + path;
+      return false;
+    }
+
+    data.assign(file.data(), file.size());
+    records.clear();
+    values.clear();
+    nested_values.clear();
+    tables.clear();
+    arrays.clear();
+    callback_returns.clear();
+    recorded = std::make_unique<CallStats>();
+
+    size_t at = sizeof(CallRecorder::magic) + 2 * sizeof(uint32_t);
+    uint32_t log_version = 0;
+    if (data.size() < at || std::memcmp(data.data(), CallRecorder::magic, sizeof(CallRecorder::magic)) != 0) {
+      error = "not a call log";
+      return false;
+    }
+
+    std::memcpy(&log_version, data.data() + sizeof(CallRecorder::magic), sizeof(log_version));
+    if (log_version != CallRecorder::version) {
+      error = "unsupported call log version " + std::to_string(log_version);
+      return false;
+    }
+
+    auto read = [&](void *out, size_t length) {
+      if (data.size() - at < length) return false;
+      std::memcpy(out, data.data() + at, length);
+      at += length;
+      return true;
+    };
+
+    auto read_text = [&](std::string_view &out) {
+      uint32_t length = 0;
+      if (!read(&length, sizeof(length)) || data.size() - at < (size_t)length + 1) return false;
+      out = std::string_view(data.data() + at, length);
+      at += (size_t)length + 1;
+      return true;
+    };
+
+    while (at < data.size()) {
+      record r{};
+      uint8_t op = 0;
+      bool ok = read(&op, 1) && read(&r.ts_ns, sizeof(r.ts_ns));
+      r.op = (CallRecorder::op_t)op;
+
+      if (ok) switch (r.op) {
+        case CallRecorder::OPEN_STDLIBS:
+        case CallRecorder::GLOBAL:
+        case CallRecorder::TABLE:
+        case CallRecorder::NEW_TABLE:
+        case CallRecorder::ENSURE_PATH:
+        case CallRecorder::CLEAR:
+        case CallRecorder::CALLBACK:
+          ok = read_text(r.text);
+          break;
+
+        case CallRecorder::PUSH:
+          r.first_value = values.size();
+          r.value_count = 1;
+          values.emplace_back();
+          ok = read_text(r.text) && read_variant(at, values.back(), 0);
+          break;
+
+        case CallRecorder::RUN:
+        case CallRecorder::LOAD: {
+          uint8_t isfile = 0;
+          ok = read(&isfile, 1) && read_text(r.text);
+          r.isfile = isfile != 0;
+          break;
+        }
+
+        case CallRecorder::CALL:
+        case CallRecorder::RETURN: {
+          uint8_t failed = 0;
+          uint32_t count = 0;
+          if (r.op == CallRecorder::CALL) ok = read(&r.ts_ns, sizeof(r.ts_ns)) && read(&r.duration_ns, sizeof(r.duration_ns)) && read(&failed, 1);
+          ok = ok && read_text(r.text) && read(&count, sizeof(count));
+
+          r.failed = failed != 0;
+          r.first_value = values.size();
+          r.value_count = count;
+          for (uint32_t i = 0; ok && i < count; i++) {
+            values.emplace_back();
+            ok = read_variant(at, values.back(), 0);
+          }
+          break;
+        }
+
+        default:
+          ok = false;
+      }
+
+      if (!ok) {
+        error = "corrupted call log at byte " + std::to_string(at);
+        return false;
+      }
+
+      if (r.op == CallRecorder::CALL) recorded->record(CallStats::LUA_PATH, r.text, r.failed, 0, r.duration_ns);
+      records.push_back(r);
+    }
+
+    // Calls are logged when they end, with the time they started: replay everything in the order it started.
+    std::stable_sort(records.begin(), records.end(), [](const record &a, const record &b) { return a.ts_ns < b.ts_ns; });
+
+    for (uint64_t i = 0; i < records.size(); i++) {
+      if (records[i].op == CallRecorder::RETURN) callback_returns[records[i].text].records.push_back(i);
+    }
+
+    return true;
+  }
+
+  bool CallReplay::read_variant(size_t &at, variant_t &out, int depth) {
+    auto read = [&](void *dst, size_t length) {
+      if (data.size() - at < length) return false;
+      std::memcpy(dst, data.data() + at, length);
+      at += length;
+      return true;
+    };
+
+    uint8_t type = 0;
+    if (!read(&type, 1)) return false;
+    out = variant_t{};
+    out.type = (decltype(out.type))type;
+
+    uint64_t length = 0;
+    switch (out.type) {
+      case variant_t::VARIANT_NIL:     return true;
+      case variant_t::VARIANT_INTEGER: return read(&out.hold.integer, sizeof(integer_t));
+      case variant_t::VARIANT_NUMBER:  return read(&out.hold.number, sizeof(number_t));
+      case variant_t::VARIANT_UID:     return read(&out.hold.uid.bytes, sizeof(uint64_t));
+      case variant_t::VARIANT_BOOL: {
+        uint8_t value = 0;
+        if (!read(&value, 1)) return false;
+        out.hold.boolean = value != 0;
+        return true;
+      }
+
+      case variant_t::VARIANT_STRING:
+      case variant_t::VARIANT_BINARY:
+        if (!read(&length, sizeof(length)) || data.size() - at < length) return false;
+        if (out.type == variant_t::VARIANT_STRING) out.hold.lstring = lstring_t{ .start = data.data() + at, .length = length, .owns = false };
+        else out.hold.binary = binary_t{ .start = (const uint8_t*)data.data() + at, .length = length, .owns = false };
+        at += length;
+        return true;
+
+      case variant_t::VARIANT_INTEGER_ARRAY:
+      case variant_t::VARIANT_NUMBER_ARRAY: {
+        if (!read(&length, sizeof(length)) || (data.size() - at) / 8 < length) return false;
+
+        // Copied: the log keeps no alignment.
+        std::string &copy = arrays.emplace_back(data.data() + at, length * 8);
+        at += length * 8;
+        if (out.type == variant_t::VARIANT_INTEGER_ARRAY) out.hold.integers = intarray_t{ .start = (const integer_t*)copy.data(), .length = length, .owns = false };
+        else out.hold.numbers = numarray_t{ .start = (const number_t*)copy.data(), .length = length, .owns = false };
+        return true;
+      }
+
+      case variant_t::VARIANT_TABLE: {
+        uint8_t keyed = 0;
+        if (depth >= max_table_depth || !read(&keyed, 1) || !read(&length, sizeof(length)) || length > data.size() - at) return false;
+
+        std::vector<variant_t> &items = nested_values.emplace_back(keyed ? length * 2 : length);
+        for (uint64_t i = 0; i < length; i++) {
+          if (keyed && !read_variant(at, items[length + i], depth + 1)) return false;
+          if (!read_variant(at, items[i], depth + 1)) return false;
+        }
+
+        vartable_t &table = tables.emplace_back(vartable_t{ 
+          .keys = keyed ? items.data() + length : nullptr, .values = items.data(), .length = length, .owns = false 
+        });
+        out.hold.table = &table;
+        return true;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  void CallReplay::next_return(std::string_view name, uint64_t &count, const variant_t *&out) {
+    count = 0;
+    out = nullptr;
+
+    auto it = callback_returns.find(name);
+    if (it == callback_returns.end() || it->second.next >= it->second.records.size()) {
+      missing_returns++;
+      return;
+    }
+
+    const record &r = records[it->second.records[it->second.next++]];
+    count = r.value_count;
+    out = values.data() + r.first_value;
+  }
+
+  syserr_t CallReplay::run(State &state) {
+    replayed = std::make_unique<CallStats>();
+    missing_returns = 0;
+    for (auto &[name, queue] : callback_returns) queue.next = 0;
+
+    state.replay = this;
+    uint64_t started = Tracer::now();
+    syserr_t err = yumsuccess;
+
+    for (const record &r : records) {
+      const char *text = r.text.data();
+      const variant_t *args = values.data() + r.first_value;
+
+      switch (r.op) {
+        case CallRecorder::OPEN_STDLIBS: state.open_stdlibs(); break;
+        case CallRecorder::GLOBAL:       state.push_global(text); break;
+        case CallRecorder::TABLE:        state.push_table(text); break;
+        case CallRecorder::NEW_TABLE:    state.new_table(text); break;
+        case CallRecorder::ENSURE_PATH:  state.ensure_path(text); break;
+        case CallRecorder::CLEAR:        state.clear(); break;
+        case CallRecorder::CALLBACK:     state.push_callback(text, replay_stub, nullptr); break;
+        case CallRecorder::PUSH:         state.push_variant(text, *args); break;
+        case CallRecorder::RUN:          err = state.run(text, r.isfile); break;
+        case CallRecorder::LOAD:         err = state.load(lstring_t{ .start = text, .length = r.text.size(), .owns = false }, r.isfile); break;
+        case CallRecorder::RETURN:       break;
+
+        case CallRecorder::CALL: {
+          uint64_t start = Tracer::now();
+          syserr_t result = state.call(text, r.text.size(), r.value_count, args, discard_results, nullptr);
+          replayed->record(CallStats::LUA_PATH, r.text, result.category != syserr_t::OK, 0, Tracer::now() - start);
+          break;
+        }
+      }
+
+      if (err.category != syserr_t::OK) break;
+    }
+
+    replay_ns = Tracer::now() - started;
+    state.replay = nullptr;
+    return err;
+  }
+
+  std::vector<CallReplay::comparison> CallReplay::compare() const {
+    std::map<std::string, comparison> merged;
+
+    auto merge = [&](const CallStats &stats, bool replay) {
+      for (const CallStats::entry &e : stats.snapshot()) {
+        comparison &c = merged[e.name];
+        c.path = e.name;
+        double mean = e.calls ? (double)(e.marshal_ns + e.exec_ns) / (double)e.calls : 0;
+
+        if (replay) {
+          c.replayed_errors = e.errors;
+          c.replayed_mean_ns = mean;
+          c.replayed_p50_ns = e.percentile(0.5);
+          c.replayed_p99_ns = e.percentile(0.99);
+        } else {
+          c.calls = e.calls;
+          c.recorded_errors = e.errors;
+          c.recorded_mean_ns = mean;
+          c.recorded_p50_ns = e.percentile(0.5);
+          c.recorded_p99_ns = e.percentile(0.99);
+        }
+      }
+    };
+
+    if (recorded) merge(*recorded, false);
+    if (replayed) merge(*replayed, true);
+
+    std::vector<comparison> result;
+    for (auto &[path, c] : merged) result.push_back(std::move(c));
+    return result;
+  }
+
+  uint64_t CallReplay::recorded_span_ns() const {
+    uint64_t first = UINT64_MAX, last = 0;
+    for (const record &r : records) {
+      first = std::min(first, r.ts_ns);
+      last = std::max(last, r.ts_ns + r.duration_ns);
+    }
+    return records.empty() ? 0 : last - first;
+  }
+}
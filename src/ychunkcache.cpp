@@ -0,0 +1,203 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/chunkcache.hpp"
+#include "inc/version/engine_version.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <cstring>
+
+namespace YumEngine::xV1 {
+  namespace {
+    struct entry_header {
+      char     magic[4];
+      uint32_t engine_version;
+      uint32_t lua_version;
+      uint8_t  integer_size;
+      uint8_t  number_size;
+      uint8_t  pointer_size;
+      uint8_t  reserved;
+      uint64_t source_hash;
+      uint64_t source_length;
+      uint64_t code_length;
+      uint64_t code_hash;
+    };
+
+    constexpr char entry_magic[4] = { 'Y', 'B', 'C', '1' };
+
+    entry_header expected_header() {
+      entry_header header = {};
+      std::memcpy(header.magic, entry_magic, sizeof(entry_magic));
+      header.engine_version = YUM_ENGINE_VERSION_INT;
+      header.lua_version    = LUA_VERSION_RELEASE_NUM;
+      header.integer_size   = sizeof(lua_Integer);
+      header.number_size    = sizeof(lua_Number);
+      header.pointer_size   = sizeof(void*);
+      return header;
+    }
+
+    int dump_writer(lua_State *, const void *p, size_t sz, void *ud) {
+      std::vector<char> *code = (std::vector<char>*)ud;
+      code->insert(code->end(), (const char*)p, (const char*)p + sz);
+      return 0;
+    }
+
+    inline uint64_t mix(uint64_t value) {
+      value ^= value >> 33;
+      value *= 0xff51afd7ed558ccdull;
+      value ^= value >> 33;
+      value *= 0xc4ceb9fe1a85ec53ull;
+      value ^= value >> 33;
+      return value;
+    }
+  }
+
+  ChunkCache::ChunkCache(const std::string &directory)
+    : directory(directory) {}
+
+  uint64_t ChunkCache::hash(const void *data, size_t length, uint64_t seed) {
+    const unsigned char *bytes = (const unsigned char*)data;
+    uint64_t h = seed ^ (length * 0x9e3779b97f4a7c15ull);
+
+    // Word at a time, so that hashing stays close to memory speed.
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+      uint64_t word;
+      std::memcpy(&word, bytes + i, 8);
+      h = (h ^ mix(word)) * 0x9e3779b97f4a7c15ull;
+      h = (h << 31) | (h >> 33);
+    }
+
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < length; i++, shift += 8) tail |= (uint64_t)bytes[i] << shift;
+
+    return mix(h ^ mix(tail));
+  }
+
+  std::string ChunkCache::entry_path(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ybc", (unsigned long long)key);
+    return directory + "/" + name;
+  }
+
+  bool ChunkCache::load_entry(lua_State *L, const std::string &path, uint64_t hash, uint64_t length) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    entry_header header;
+    entry_header expected = expected_header();
+    std::vector<char> code;
+
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+      && std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0
+      && header.engine_version == expected.engine_version
+      && header.lua_version    == expected.lua_version
+      && header.integer_size   == expected.integer_size
+      && header.number_size    == expected.number_size
+      && header.pointer_size   == expected.pointer_size
+      && header.source_hash    == hash
+      && header.source_length  == length;
+
+    // The length comes from the disk: a truncated or corrupt entry must not size the buffer.
+    if (valid) {
+      long at = ftell(file);
+      valid = at >= 0 && fseek(file, 0, SEEK_END) == 0;
+      long end = valid ? ftell(file) : -1;
+      valid = valid && end >= at && header.code_length == (uint64_t)(end - at) && fseek(file, at, SEEK_SET) == 0;
+    }
+
+    if (valid) {
+      code.resize(header.code_length);
+      valid = fread(code.data(), 1, code.size(), file) == code.size()
+        && ChunkCache::hash(code.data(), code.size(), 0) == header.code_hash;
+    }
+
+    fclose(file);
+    if (!valid) return false;
+
+    // The chunk name stored in the bytecode is used, it was part of the key.
+    if (luaL_loadbufferx(L, code.data(), code.size(), "=(bytecode cache)", "b") != LUA_OK) {
+      lua_pop(L, 1);
+      return false;
+    }
+
+    return true;
+  }
+
+  void ChunkCache::store_entry(lua_State *L, const std::string &path, uint64_t hash, uint64_t length) {
+    std::vector<char> code;
+    if (lua_dump(L, dump_writer, &code, 0) != 0) return;
+
+    entry_header header = expected_header();
+    header.source_hash   = hash;
+    header.source_length = length;
+    header.code_length   = code.size();
+    header.code_hash     = ChunkCache::hash(code.data(), code.size(), 0);
+
+    // Written aside then renamed, so that concurrent readers never see a partial entry.
+    static std::atomic<uint64_t> sequence = std::random_device{}();
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.tmp", (unsigned long long)mix(sequence.fetch_add(1)));
+    std::string temporary = path + suffix;
+
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file) return;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+      && fwrite(code.data(), 1, code.size(), file) == code.size();
+
+    if (fclose(file) != 0 || !written || rename(temporary.c_str(), path.c_str()) != 0) {
+      remove(temporary.c_str());
+    }
+  }
+
+  int ChunkCache::load(lua_State *L, const char *source, size_t length, const char *chunkname) {
+    uint64_t source_hash = hash(source, length, 0);
+
+    uint64_t key = hash(chunkname, strlen(chunkname), source_hash);
+    key = mix(key ^ (((uint64_t)YUM_ENGINE_VERSION_INT << 32) | LUA_VERSION_RELEASE_NUM));
+
+    std::string path = entry_path(key);
+
+    if (load_entry(L, path, source_hash, length)) {
+      hits.fetch_add(1, std::memory_order_relaxed);
+      return LUA_OK;
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+
+    int status = luaL_loadbufferx(L, source, length, chunkname, "t");
+    if (status == LUA_OK) store_entry(L, path, source_hash, length);
+
+    return status;
+  }
+
+  uint64_t ChunkCache::hit_count() const {
+    return hits.load(std::memory_order_relaxed);
+  }
+
+  uint64_t ChunkCache::miss_count() const {
+    return misses.load(std::memory_order_relaxed);
+  }
+}
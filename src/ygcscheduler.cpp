@@ -0,0 +1,121 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/gcscheduler.hpp"
+
+#include <chrono>
+#include <cassert>
+#include <algorithm>
+
+namespace YumEngine::xV1 {
+  GcScheduler::GcScheduler(uint64_t nthreads, uint64_t period_us, uint64_t budget_us, uint64_t threshold)
+    : nthreads(std::max<uint64_t>(nthreads, 1)), period_us(period_us), budget_us(budget_us), threshold(threshold) {
+    threads.reserve(this->nthreads);
+    for (uint64_t i = 0; i < this->nthreads; i++) threads.emplace_back(&GcScheduler::run, this);
+  }
+
+  GcScheduler::~GcScheduler() {
+    stopping.store(true);
+    {
+      std::lock_guard lock(sleep_lock);
+      wake.notify_all();
+    }
+
+    for (std::thread &thread : threads) thread.join();
+
+    // Restarting a taken over collector here would race with the thread using the State: that is remove()'s job.
+    assert(states.empty() && "States must be removed from their GcScheduler before it is destroyed");
+    for (entry &e : states) {
+      e.state->gc_scheduled.store(false, std::memory_order_release);
+      e.state->gc_scheduler = nullptr;
+    }
+  }
+
+  void GcScheduler::add(State &state, bool take_over) {
+    if (state.gc_scheduler) return;
+    if (take_over) state.gc_stop();
+
+    std::lock_guard lock(states_lock);
+    states.push_back(entry{ .state = &state, .took_over = take_over });
+    state.gc_scheduler = this;
+    state.gc_scheduled.store(true, std::memory_order_release);
+  }
+
+  void GcScheduler::remove(State &state) {
+    if (state.gc_scheduler != this) return;
+    state.gc_scheduler = nullptr;
+
+    bool took_over = false;
+    {
+      std::lock_guard lock(states_lock);
+      auto it = std::find_if(states.begin(), states.end(), [&](const entry &e) { return e.state == &state; });
+      if (it == states.end()) return;
+
+      took_over = it->took_over;
+      states.erase(it);
+    }
+
+    // A thread may have picked the State before it left the list: wait for it to hand the State back.
+    state.gc_handoff_requested.store(true, std::memory_order_relaxed);
+    state.gc_handoff.lock();
+    state.gc_scheduled.store(false, std::memory_order_release);
+    state.gc_handoff_requested.store(false, std::memory_order_relaxed);
+    state.gc_handoff.unlock();
+
+    if (took_over) state.gc_restart();
+  }
+
+  State *GcScheduler::next(std::unique_lock<std::mutex> &handoff) {
+    std::lock_guard lock(states_lock);
+    if (states.empty()) return nullptr;
+
+    // Locked before states_lock is released, so that remove() waits for it.
+    State *state = states[cursor++ % states.size()].state;
+    handoff = std::unique_lock(state->gc_handoff, std::try_to_lock);
+    return state;
+  }
+
+  void GcScheduler::run() {
+    while (!stopping.load()) {
+      {
+        std::unique_lock lock(sleep_lock);
+        wake.wait_for(lock, std::chrono::microseconds(period_us), [this] { return stopping.load(); });
+      }
+
+      uint64_t count;
+      {
+        std::lock_guard lock(states_lock);
+        count = (states.size() + nthreads - 1) / nthreads;
+      }
+
+      // The threads share one cursor: each visits its part of the States per period.
+      for (uint64_t i = 0; i < count && !stopping.load(); i++) {
+        std::unique_lock<std::mutex> handoff;
+        State *state = next(handoff);
+        if (!state) break;
+        if (!handoff.owns_lock()) continue; // In use by the host, or by another thread.
+
+        state->gc_background(budget_us, threshold);
+      }
+    }
+  }
+}
@@ -0,0 +1,52 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/gcscheduler.hpp"
+
+#include <exception>
+
+using namespace YumEngine::xV1;
+
+yumlibcxx_c_header_decoration_begin
+
+YumGcScheduler *yumlibc_library_member(gcsched_new)(uint64_t nthreads, uint64_t period_us, uint64_t budget_us, uint64_t threshold) {
+  try {
+    return new YumGcScheduler(nthreads, period_us, budget_us, threshold);
+  } catch (const std::exception &) {
+    return nullptr;
+  }
+}
+
+/* Every State must have been removed (or destroyed) first. */
+void yumlibc_library_member(gcsched_delete)(YumGcScheduler *scheduler) {
+  if (scheduler) delete scheduler;
+}
+
+void yumlibc_library_member(gcsched_add)(YumGcScheduler *scheduler, YumState *state, boolean_t take_over) {
+  if (scheduler && state) scheduler->add(*state, take_over);
+}
+
+void yumlibc_library_member(gcsched_remove)(YumGcScheduler *scheduler, YumState *state) {
+  if (scheduler && state) scheduler->remove(*state);
+}
+
+yumlibcxx_c_header_decoration_end
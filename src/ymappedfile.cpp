@@ -0,0 +1,172 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/system/mappedfile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+namespace YumEngine::xV1 {
+  MappedFile::~MappedFile() {
+    close();
+  }
+
+  MappedFile::MappedFile(MappedFile &&other) noexcept
+    : start(std::exchange(other.start, nullptr)), length(std::exchange(other.length, 0)),
+      mapped(std::exchange(other.mapped, false)), handle(std::exchange(other.handle, nullptr)) {}
+
+  MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      close();
+      start  = std::exchange(other.start, nullptr);
+      length = std::exchange(other.length, 0);
+      mapped = std::exchange(other.mapped, false);
+      handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+  }
+
+  void MappedFile::close() {
+    if (mapped) {
+#ifdef _WIN32
+      UnmapViewOfFile(start);
+      CloseHandle((HANDLE)handle);
+#else
+      munmap((void*)start, length);
+#endif
+    } else if (length) {
+      free((void*)start);
+    }
+
+    start  = nullptr;
+    length = 0;
+    mapped = false;
+    handle = nullptr;
+  }
+
+#ifdef _WIN32
+  bool MappedFile::open(const char *path, bool) {
+    // Large pages need SeLockMemoryPrivilege and cannot back file views, so the hint is ignored here.
+    close();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      return false;
+    }
+
+    if (size.QuadPart == 0) {
+      CloseHandle(file);
+      start = "";
+      return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return false;
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+      CloseHandle(mapping);
+      return false;
+    }
+
+    start  = (const char*)view;
+    length = (size_t)size.QuadPart;
+    mapped = true;
+    handle = mapping;
+    return true;
+  }
+#else
+  bool MappedFile::open(const char *path, bool large_pages) {
+    close();
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      ::close(fd);
+      return false;
+    }
+
+    if (info.st_size == 0) {
+      ::close(fd);
+      start = "";
+      return true;
+    }
+
+    length = (size_t)info.st_size;
+    void *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (view != MAP_FAILED) {
+      ::close(fd);
+      start  = (const char*)view;
+      mapped = true;
+
+      madvise(view, length, MADV_SEQUENTIAL);
+      madvise(view, length, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+      if (large_pages) madvise(view, length, MADV_HUGEPAGE);
+#else
+      (void)large_pages;
+#endif
+      return true;
+    }
+
+    // Not mappable (pipes, some special filesystems): read it instead.
+    char *buffer = (char*)malloc(length);
+    size_t done = 0;
+
+    while (buffer && done < length) {
+      ssize_t n = read(fd, buffer + done, length - done);
+      if (n <= 0) break;
+      done += (size_t)n;
+    }
+
+    ::close(fd);
+
+    if (!buffer || done != length) {
+      free(buffer);
+      length = 0;
+      return false;
+    }
+
+    start = buffer;
+    return true;
+  }
+#endif
+}
@@ -0,0 +1,147 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/system/perfcounters.hpp"
+
+#ifdef __linux__
+#  include <unistd.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <linux/perf_event.h>
+#  include <cstring>
+#endif
+
+namespace YumEngine::xV1 {
+#ifdef __linux__
+  namespace {
+    struct counter_config {
+      uint32_t type;
+      uint64_t config;
+    };
+
+    constexpr counter_config configs[PerfCounters::counter_count] = {
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+      { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    /**
+     * One group per thread, cycles leading: a single read returns every counter, measured over the same time.
+     * The group is scheduled as a whole; where the PMU cannot hold it, it is multiplexed and counts stall meanwhile.
+     */
+    struct thread_group {
+      bool tried  = false;
+      int  leader = -1;
+      int  fds[PerfCounters::counter_count];
+      int  slots[PerfCounters::counter_count]; // Position of each counter in a group read, -1 if not opened.
+      int  opened = 0;
+
+      thread_group() {
+        for (int i = 0; i < PerfCounters::counter_count; i++) fds[i] = slots[i] = -1;
+      }
+
+      ~thread_group() {
+        close();
+      }
+
+      void close() {
+        for (int i = 0; i < PerfCounters::counter_count; i++) {
+          if (fds[i] >= 0) ::close(fds[i]);
+          fds[i] = slots[i] = -1;
+        }
+        leader = -1;
+        opened = 0;
+      }
+
+      bool open() {
+        tried = true;
+
+        for (int i = 0; i < PerfCounters::counter_count; i++) {
+          perf_event_attr attr;
+          std::memset(&attr, 0, sizeof(attr));
+          attr.size           = sizeof(attr);
+          attr.type           = configs[i].type;
+          attr.config         = configs[i].config;
+          attr.read_format    = PERF_FORMAT_GROUP;
+          attr.disabled       = leader < 0;
+          attr.exclude_kernel = 1;
+          attr.exclude_hv     = 1;
+
+          int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+          if (fd < 0) {
+            if (i == PerfCounters::CYCLES) return false; // Without a leader, there is no group.
+            continue; // The CPU may lack this one: the others still count.
+          }
+
+          if (leader < 0) leader = fd;
+          fds[i] = fd;
+          slots[i] = opened++;
+        }
+
+        if (ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0) return true;
+
+        // Leave the thread with nothing opened, rather than a group that does not count.
+        close();
+        return false;
+      }
+    };
+
+    thread_local thread_group group;
+  }
+
+  bool PerfCounters::read(sample &out) {
+    if (!group.tried) group.open();
+    if (group.leader < 0) return false;
+
+    uint64_t buffer[1 + counter_count];
+    ssize_t length = ::read(group.leader, buffer, sizeof(buffer));
+    if (length < (ssize_t)sizeof(uint64_t) || buffer[0] != (uint64_t)group.opened) return false;
+
+    for (int i = 0; i < counter_count; i++) out.values[i] = group.slots[i] >= 0 ? buffer[1 + group.slots[i]] : 0;
+    return true;
+  }
+#else
+  bool PerfCounters::read(sample &) {
+    return false;
+  }
+#endif
+
+  bool PerfCounters::since(sample &start) {
+    sample now;
+    if (!read(now)) return false;
+
+    for (int i = 0; i < counter_count; i++) start.values[i] = now.values[i] - start.values[i];
+    return true;
+  }
+
+  bool PerfCounters::available() {
+    sample ignored;
+    return read(ignored);
+  }
+
+  const char *PerfCounters::name(counter_t counter) {
+    static const char *const names[counter_count] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+    return (int)counter < counter_count ? names[counter] : "unknown";
+  }
+}
@@ -0,0 +1,113 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/profiler.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace YumEngine::xV1 {
+  namespace {
+    void append_frame(std::string &out, lua_State *L, lua_Debug &ar) {
+      lua_getinfo(L, "Sn", &ar);
+
+      out += ar.name ? ar.name : (*ar.what == 'm' ? "main" : "?");
+      if (*ar.what == 'C') {
+        out += "@[C]";
+      } else {
+        out += '@';
+        out += ar.short_src;
+        out += ':';
+        out += std::to_string(ar.linedefined);
+      }
+    }
+  }
+
+  void Profiler::sample(lua_State *L) {
+    lua_Debug levels[max_depth];
+    int depth = 0;
+    while (depth < max_depth && lua_getstack(L, depth, &levels[depth])) depth++;
+
+    std::string stack;
+    for (int i = depth - 1; i >= 0; i--) {
+      size_t start = stack.size();
+      append_frame(stack, L, levels[i]);
+      std::replace(stack.begin() + (ptrdiff_t)start, stack.end(), ';', ':'); // ';' separates frames.
+      if (i > 0) stack += ';';
+    }
+
+    if (stack.empty()) return;
+
+    stacks[stack]++;
+    samples++;
+  }
+
+  std::string Profiler::folded() const {
+    std::string out;
+    for (const auto &[stack, count] : stacks) {
+      out += stack;
+      out += ' ';
+      out += std::to_string(count);
+      out += '\n';
+    }
+    return out;
+  }
+
+  std::vector<Profiler::entry> Profiler::top(uint64_t n) const {
+    std::unordered_map<std::string_view, entry> functions;
+    std::unordered_set<std::string_view> seen;
+
+    for (const auto &[stack, count] : stacks) {
+      seen.clear();
+
+      size_t start = 0;
+      while (start <= stack.size()) {
+        size_t end = stack.find(';', start);
+        if (end == std::string::npos) end = stack.size();
+
+        std::string_view frame(stack.data() + start, end - start);
+        entry &e = functions.try_emplace(frame, entry{ std::string(frame), 0, 0 }).first->second;
+
+        if (seen.insert(frame).second) e.total += count; // Recursion counts once.
+        if (end == stack.size()) e.self += count;
+
+        start = end + 1;
+      }
+    }
+
+    std::vector<entry> result;
+    result.reserve(functions.size());
+    for (auto &[frame, e] : functions) result.push_back(std::move(e));
+
+    std::sort(result.begin(), result.end(), [](const entry &a, const entry &b) {
+      return a.self != b.self ? a.self > b.self : a.total > b.total;
+    });
+
+    if (result.size() > n) result.resize(n);
+    return result;
+  }
+
+  void Profiler::reset() {
+    stacks.clear();
+    samples = 0;
+  }
+}
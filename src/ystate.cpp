@@ -23,40 +23,297 @@
 #include "inc/yumem.hpp"
 #include "inc/lua/lua.hpp"
 #include "inc/types/state.hpp"
+#include "inc/types/gcscheduler.hpp"
 #include "inc/types/variant.h"
 #include "inc/types/variant.hpp"
 #include "inc/debug/dbgpoints.h"
+#include "inc/debug/tracer.hpp"
 #include "inc/types/system/err.h"
 #include "inc/utils/ystringutils.h"
 #include "inc/utils/ystringutils.hpp"
 #include "inc/types/system/exception.hpp"
 #include "inc/types/containers/string.hpp"
 
+#include <new>
+#include <chrono>
+#include <optional>
 #include <vector>
-#include <cassert>
+#include <utility>
+#include <algorithm>
+#include <string_view>
 #include <unordered_map>
+#include <cstdio>
+#include <cassert>
+#include <cstring>
 
 namespace YumEngine::xV1 {
   namespace _static_units {
+    /** @brief Internal : Tables nested deeper than this are read back as NIL. */
+    constexpr int max_table_depth = 32;
+
+    /** @brief Internal : Times a value changing while being converted is measured again, before giving up. */
+    constexpr int conversion_attempts = 3;
+
+    /** @brief Internal : Stack slots a level of conversion takes: the key and value iterated, and what is looked at. */
+    constexpr int table_level_slots = 4;
+
+    /** @brief Internal : Makes room on the stack for converting tables down to max_table_depth. */
+    inline bool reserve_table_stack(lua_State *L) {
+      return lua_checkstack(L, (max_table_depth + 1) * table_level_slots);
+    }
+
+    /** @brief Internal : A NIL variant, what unreadable values convert to. */
+    inline variant_t nil_variant() {
+      return variant_t{ .hold = {}, .type = variant_t::VARIANT_NIL };
+    }
+
+    /** @brief Internal : A table (absolute index) collecting the strings a borrowing conversion points into. */
+    struct table_pins {
+      int         table;
+      lua_Integer count = 0;
+
+      inline void pin(lua_State *L, int idx) {
+        lua_pushvalue(L, idx);
+        lua_rawseti(L, table, ++count);
+      }
+    };
+
+    /** 
+     * @brief Internal : Lua tables being converted, from the outermost one. Breaks reference cycles.
+     * Measuring and converting a value must walk it with the same path settings, so they agree on the memory it takes.
+     */
+    struct table_path {
+      const void *tables[max_table_depth];
+      int         depth = 0;
+      int         limit = max_table_depth; // 0 when the stack could not be reserved: no table is entered.
+
+      /** @brief Tables met so far. A table referenced several times is converted once, and its variants shared. */
+      std::unordered_map<const void*, variant_t> seen;
+
+      /** @brief Keeps borrowed strings alive on their own, as the tables holding them may change. Null when not borrowing for long. */
+      table_pins *pins = nullptr;
+
+      explicit table_path(bool reserved) : limit(reserved ? max_table_depth : 0) {}
+
+      inline bool can_enter(lua_State *L, int idx) const {
+        if (depth >= limit) return false;
+
+        const void *table = lua_topointer(L, idx);
+        for (int i = 0; i < depth; i++) {
+          if (tables[i] == table) return false;
+        }
+        return true;
+      }
+
+      inline void enter(lua_State *L, int idx) { tables[depth++] = lua_topointer(L, idx); }
+      inline void leave() { depth--; }
+    };
+
+    /** @brief Internal : Memory taken by converted tables. Tables, variants, packed scalars, then bytes, in one block. */
+    struct table_extent {
+      uint64_t tables   = 0;
+      uint64_t variants = 0;
+      uint64_t scalars  = 0;
+      uint64_t bytes    = 0;
+
+      inline uint64_t size() const {
+        return tables * sizeof(vartable_t) + variants * sizeof(variant_t) + scalars * sizeof(integer_t) + bytes;
+      }
+
+      inline bool aligned() const { return tables > 0 || scalars > 0; }
+    };
+
+    static_assert(sizeof(integer_t) == sizeof(number_t), "packed arrays share the scalar area");
+
+    enum class table_kind { DATA, UID, BINARY };
+
+    /** 
+     * @brief Internal : Pushes a marker field of the table at `idx` (absolute), without running metamethods. 
+     * Both conversion passes must see the same table, and __index could change it in between.
+     */
+    static int push_marker(lua_State *L, int idx, const char *marker) {
+      lua_pushstring(L, marker);
+      return lua_rawget(L, idx);
+    }
+
+    /** @brief Internal : Tells whether a table wraps an UID, a binary, or is plain data. */
+    static table_kind kind_of_table(lua_State *L, int idx) {
+      bool is_uid = push_marker(L, idx, "__yumuid") != LUA_TNIL;
+      lua_pop(L, 1);
+      if (is_uid) return table_kind::UID;
+
+      bool is_binary = push_marker(L, idx, "__yumbytes") != LUA_TNIL;
+      lua_pop(L, 1);
+      return is_binary ? table_kind::BINARY : table_kind::DATA;
+    }
+
+    /** @brief Internal : What a table holds. */
+    struct table_shape {
+      uint64_t entries  = 0;
+      bool     is_array = true; // Keys are exactly 1..n.
+      bool     integers = true; // Every value is an integer.
+      bool     numbers  = true; // Every value is a number.
+
+      /** @brief Non-empty sequences of numbers are read back as packed arrays. */
+      inline bool packed() const { return is_array && numbers && entries > 0; }
+    };
+
+    /** @brief Internal : Walks a table once to find its shape. */
+    static table_shape shape_of_table(lua_State *L, int idx) {
+      table_shape shape;
+      lua_Unsigned border = lua_rawlen(L, idx);
+
+      lua_pushnil(L);
+      while (lua_next(L, idx)) {
+        if (shape.is_array) {
+          lua_Integer key = lua_isinteger(L, -2) ? lua_tointeger(L, -2) : 0;
+          shape.is_array = key >= 1 && (lua_Unsigned)key <= border;
+        }
+
+        if (shape.numbers) {
+          shape.numbers = lua_type(L, -1) == LUA_TNUMBER;
+          shape.integers = shape.integers && shape.numbers && lua_isinteger(L, -1);
+        }
+
+        shape.entries++;
+        lua_pop(L, 1);
+      }
+
+      shape.is_array = shape.is_array && shape.entries == border;
+      shape.integers = shape.integers && shape.numbers;
+      return shape;
+    }
+
+    /** @brief Internal : Reads a sequence of numbers into `memory`, and returns it as a packed array. */
+    static variant_t packed_from_lua(lua_State *L, int idx, const table_shape &shape, void *memory, boolean_t owns) {
+      if (shape.integers) {
+        integer_t *integers = (integer_t*)memory;
+        for (uint64_t i = 0; i < shape.entries; i++) {
+          lua_rawgeti(L, idx, (lua_Integer)(i + 1));
+          integers[i] = (integer_t)lua_tointeger(L, -1);
+          lua_pop(L, 1);
+        }
+
+        return CVariant(intarray_t{ .start = integers, .length = shape.entries, .owns = owns });
+      }
+
+      number_t *numbers = (number_t*)memory;
+      for (uint64_t i = 0; i < shape.entries; i++) {
+        lua_rawgeti(L, idx, (lua_Integer)(i + 1));
+        numbers[i] = (number_t)lua_tonumber(L, -1);
+        lua_pop(L, 1);
+      }
+
+      return CVariant(numarray_t{ .start = numbers, .length = shape.entries, .owns = owns });
+    }
+
+    static void measure_value(lua_State *L, int idx, bool copy, table_path &path, table_extent &extent);
+
+    /** 
+     * @brief Internal : Measures the memory a table takes once converted.
+     * @param copy Whether nested strings and binaries are copied, or borrowed from Lua.
+     */
+    static void measure_table(lua_State *L, int idx, bool copy, table_path &path, table_extent &extent) {
+      table_shape shape = shape_of_table(L, idx);
+      if (shape.packed()) {
+        extent.scalars += shape.entries;
+        return;
+      }
+
+      bool is_array = shape.is_array;
+      extent.tables++;
+      extent.variants += is_array ? shape.entries : 2 * shape.entries;
+
+      // Same order as table_block::table, so that shared tables are met first at the same depth.
+      path.enter(L, idx);
+      if (is_array) {
+        for (uint64_t i = 0; i < shape.entries; i++) {
+          lua_rawgeti(L, idx, (lua_Integer)(i + 1));
+          measure_value(L, lua_gettop(L), copy, path, extent);
+          lua_pop(L, 1);
+        }
+      } else {
+        lua_pushnil(L);
+        while (lua_next(L, idx)) {
+          int top = lua_gettop(L);
+          measure_value(L, top - 1, copy, path, extent);
+          measure_value(L, top, copy, path, extent);
+          lua_pop(L, 1);
+        }
+      }
+      path.leave();
+    }
+
+    /** @note Mirrors variant_from_lua_with(). */
+    static void measure_value(lua_State *L, int idx, bool copy, table_path &path, table_extent &extent) {
+      switch (lua_type(L, idx)) {
+        case LUA_TSTRING: 
+          if (copy) extent.bytes += lua_rawlen(L, idx);
+          break;
+        case LUA_TTABLE:
+          switch (kind_of_table(L, idx)) {
+            case table_kind::BINARY:
+              if (copy) {
+                size_t len = 0;
+                push_marker(L, idx, "__yumbytes");
+                lua_tolstring(L, -1, &len);
+                lua_pop(L, 1);
+                extent.bytes += len;
+              }
+              break;
+            case table_kind::DATA:
+              // Tables met before take no more memory: their variants are shared.
+              if (path.can_enter(L, idx) && path.seen.emplace(lua_topointer(L, idx), variant_t{}).second) {
+                measure_table(L, idx, copy, path, extent);
+              }
+              break;
+            default: break;
+          }
+          break;
+        default: break;
+      }
+    }
+
+    /** @brief Internal : Memory a value takes in a frame's arena, alignment included. */
+    static uint64_t arena_bytes_of(lua_State *L, int idx, bool copy, bool reserved) {
+      table_path path(reserved);
+      table_extent extent;
+      measure_value(L, idx, copy, path, extent);
+      return extent.size() + (extent.aligned() ? alignof(variant_t) - 1 : 0);
+    }
+
+    /** @brief Internal : Aligns an arena cursor for tables. */
+    static char *align_for_tables(char *cursor) {
+      uintptr_t at = (uintptr_t)cursor;
+      at = (at + alignof(variant_t) - 1) & ~(uintptr_t)(alignof(variant_t) - 1);
+      return (char*)at;
+    }
+
     /**
      * @brief Internal function : Converts Lua variables to C values.
      * 
-     * @warning You may free returned values! You can use the yumfree_array() function (or yumfree for C++) since the 3.5 (coming with the C++ SDK).
      * @param L lua state.
-     * @param idx Index.
+     * @param idx Index (absolute).
+     * @param sink Where strings, binaries and tables go. Has `owns`, `keep(bytes, len)` and `table(L, idx, path)`,
+     *             the latter returning a table or packed array variant (NIL when the table cannot be read).
+     *             Sinks never write past the memory they measured, see table_block.
+     * @param path Tables being converted.
      * @return A C variant.
      */
-    static variant_t variant_from_lua(lua_State *L, int idx) {
+    template <typename Sink>
+    static variant_t variant_from_lua_with(lua_State *L, int idx, Sink &sink, table_path &path) {
       int type = lua_type(L, idx);
       switch (type) {
         case LUA_TBOOLEAN: return CVariant((boolean_t)lua_toboolean(L, idx)).c();
         case LUA_TSTRING: {
+          if (path.pins && path.depth > 0) path.pins->pin(L, idx);
+
           size_t len;
           const char *cstr = lua_tolstring(L, idx, &len);
           lstring_t lstring {
-            .start = yumstrcpy(cstr, len),
+            .start = sink.keep(cstr, len),
             .length = len, 
-            .owns = true
+            .owns = sink.owns
           };
 
           return CVariant(lstring);
@@ -68,7 +325,7 @@ namespace YumEngine::xV1 {
         }
         case LUA_TTABLE: {
           // Check if it's a UID table
-          lua_getfield(L, idx, "__yumuid");
+          push_marker(L, idx, "__yumuid");
           if (!lua_isnil(L, -1)) {
             uint64_t bytes = lua_tointeger(L, -1);
             lua_pop(L, 1);
@@ -77,21 +334,304 @@ namespace YumEngine::xV1 {
 
           lua_pop(L, 1); // pop nil
           // Check if it's a binary table
-          lua_getfield(L, idx, "__yumbytes");
+          push_marker(L, idx, "__yumbytes");
           if (!lua_isnil(L, -1)) {
             size_t len;
-            const char *data = yumstrcpy(lua_tolstring(L, -1, &len), len);
+            const char *bytes = lua_tolstring(L, -1, &len);
+            if (path.pins) path.pins->pin(L, -1);
+            const char *data = sink.keep(bytes, len);
             lua_pop(L, 1);
-            return CVariant(binary_t{.start = (const uint8_t*)data, .length = len, .owns = true});
+            return CVariant(binary_t{.start = (const uint8_t*)data, .length = len, .owns = sink.owns});
           }
           lua_pop(L, 1); // pop nil
 
-          // Well tables not for now.
-          return variant_t{.type = variant_t::VARIANT_NIL};
+          return sink.table(L, idx, path);
+        }
+
+        default: return nil_variant();
+      }
+    }
+
+    /** 
+     * @brief Internal : Hands out the memory of measured tables. Nested values never own their memory.
+     * Every write is checked against the measured extent: a finalizer may change a table between the two passes.
+     */
+    struct table_block {
+      static constexpr boolean_t owns = yumfalse;
+
+      vartable_t *tables;
+      variant_t  *variants;
+      integer_t  *scalars;
+      char       *bytes; // Null when strings and binaries are borrowed from Lua.
+
+      vartable_t *tables_end;
+      variant_t  *variants_end;
+      integer_t  *scalars_end;
+      char       *bytes_end;
+      bool        overflowed = false;
+
+      inline static table_block over(char *memory, const table_extent &extent, bool copy) {
+        vartable_t *tables = (vartable_t*)memory;
+        variant_t *variants = (variant_t*)(tables + extent.tables);
+        integer_t *scalars = (integer_t*)(variants + extent.variants);
+        char *bytes = (char*)(scalars + extent.scalars);
+        return table_block{
+          .tables = tables,
+          .variants = variants,
+          .scalars = scalars,
+          .bytes = copy ? bytes : nullptr,
+          .tables_end = (vartable_t*)variants,
+          .variants_end = (variant_t*)scalars,
+          .scalars_end = (integer_t*)bytes,
+          .bytes_end = copy ? bytes + extent.bytes : nullptr
+        };
+      }
+
+      inline const char *keep(const char *src, size_t len) {
+        if (!bytes) return src;
+        if (len > (size_t)(bytes_end - bytes)) {
+          overflowed = true;
+          return bytes;
+        }
+
+        char *at = bytes;
+        if (len > 0) std::memcpy(at, src, len);
+        bytes += len;
+        return at;
+      }
+
+      /** @note Array-shaped tables go through lua_rawgeti, map-shaped ones through lua_next. */
+      inline variant_t table(lua_State *L, int idx, table_path &path) {
+        if (!path.can_enter(L, idx)) return nil_variant();
+
+        const void *address = lua_topointer(L, idx);
+        auto seen = path.seen.find(address);
+        if (seen != path.seen.end()) return seen->second;
+
+        variant_t result = convert(L, idx, path);
+        path.seen.emplace(address, result);
+        return result;
+      }
+
+      inline variant_t convert(lua_State *L, int idx, table_path &path) {
+        table_shape shape = shape_of_table(L, idx);
+        if (shape.packed()) {
+          if (shape.entries > (uint64_t)(scalars_end - scalars)) return overflow();
+
+          integer_t *memory = scalars;
+          scalars += shape.entries;
+          return packed_from_lua(L, idx, shape, memory, yumfalse);
+        }
+
+        bool is_array = shape.is_array;
+        uint64_t n = shape.entries;
+        if (tables == tables_end || (is_array ? n : 2 * n) > (uint64_t)(variants_end - variants)) return overflow();
+
+        vartable_t *table = tables++;
+        table->length = n;
+        table->owns = yumfalse;
+        table->values = variants;
+        table->keys = nullptr;
+        variants += n;
+
+        if (!is_array) {
+          table->keys = variants;
+          variants += n;
+        }
+
+        path.enter(L, idx);
+        if (is_array) {
+          for (uint64_t i = 0; i < n; i++) {
+            lua_rawgeti(L, idx, (lua_Integer)(i + 1));
+            table->values[i] = variant_from_lua_with(L, lua_gettop(L), *this, path);
+            lua_pop(L, 1);
+          }
+        } else {
+          uint64_t i = 0;
+          lua_pushnil(L);
+          while (lua_next(L, idx)) {
+            if (i == n) {
+              overflowed = true;
+              lua_pop(L, 2);
+              break;
+            }
+
+            int top = lua_gettop(L);
+            table->keys[i] = variant_from_lua_with(L, top - 1, *this, path);
+            table->values[i] = variant_from_lua_with(L, top, *this, path);
+            lua_pop(L, 1);
+            i++;
+          }
+        }
+        path.leave();
+
+        return CVariant(table);
+      }
+
+      inline variant_t overflow() {
+        overflowed = true;
+        return nil_variant();
+      }
+    };
+
+    /** 
+     * @brief Internal : Values owning their memory. A table and everything it holds is a single yumalloc.
+     * A table changed while being converted is measured again, and read back as NIL if it keeps changing.
+     */
+    struct owning_sink {
+      static constexpr boolean_t owns = yumtrue;
+
+      inline const char *keep(const char *src, size_t len) { return yumstrcpy(src, len); }
+
+      inline variant_t table(lua_State *L, int idx, table_path &path) {
+        if (!path.can_enter(L, idx)) return nil_variant();
+
+        // A packed array is its own allocation.
+        table_shape shape = shape_of_table(L, idx);
+        if (shape.packed()) {
+          return packed_from_lua(L, idx, shape, yumalloc(shape.entries * sizeof(integer_t)), yumtrue);
+        }
+
+        for (int attempt = 0; attempt < conversion_attempts; attempt++) {
+          table_extent extent;
+          measure_table(L, idx, true, path, extent);
+          path.seen.clear();
+
+          char *memory = (char*)yumalloc(extent.size());
+          table_block block = table_block::over(memory, extent, true);
+          variant_t root = block.table(L, idx, path);
+          path.seen.clear();
+
+          // A table that became a packed array meanwhile does not start the block: measured again too.
+          if (!block.overflowed && root.type == variant_t::VARIANT_TABLE) {
+            root.hold.table->owns = yumtrue;
+            return root;
+          }
+
+          yumfree(memory);
+        }
+
+        return nil_variant();
+      }
+    };
+
+    /** 
+     * @brief Internal : Values living in an arena, measured beforehand.
+     * @param copy Whether strings and binaries are copied into the arena, or borrowed from Lua.
+     */
+    struct arena_sink {
+      static constexpr boolean_t owns = yumfalse;
+
+      char *cursor;
+      char *end;
+      bool  copy;
+      bool  overflowed = false;
+
+      inline const char *keep(const char *src, size_t len) {
+        if (!copy) return src;
+        if (len > (size_t)(end - cursor)) {
+          overflowed = true;
+          return cursor;
+        }
+
+        char *at = cursor;
+        if (len > 0) std::memcpy(at, src, len);
+        cursor += len;
+        return at;
+      }
+
+      inline variant_t table(lua_State *L, int idx, table_path &path) {
+        if (!path.can_enter(L, idx)) return nil_variant();
+
+        table_extent extent;
+        measure_table(L, idx, copy, path, extent);
+        path.seen.clear();
+
+        char *memory = align_for_tables(cursor);
+        if (memory > end || extent.size() > (uint64_t)(end - memory)) {
+          overflowed = true;
+          return nil_variant();
         }
+        cursor = memory + extent.size();
+
+        table_block block = table_block::over(memory, extent, copy);
+        variant_t result = block.table(L, idx, path);
+        overflowed = overflowed || block.overflowed;
+        return result;
+      }
+    };
+
+    /**
+     * @brief Internal function : Converts Lua variables to C values.
+     * 
+     * @warning You may free returned values! You can use the yumfree_array() function (or yumfree for C++) since the 3.5 (coming with the C++ SDK).
+     * @param L lua state.
+     * @param idx Index.
+     * @return A C variant.
+     */
+    static variant_t variant_from_lua(lua_State *L, int idx) {
+      owning_sink sink;
+      table_path path(reserve_table_stack(L));
+      return variant_from_lua_with(L, lua_absindex(L, idx), sink, path);
+    }
+
+    /**
+     * @brief Internal function : Converts a Lua variable to a C value, borrowing strings and binaries from Lua.
+     * @param scratch Holds the converted tables. Reused from a call to another.
+     * @warning Returned values are only valid while the Lua value stays on the stack and `scratch` is untouched.
+     */
+    static variant_t variant_borrowed_from_lua(lua_State *L, int idx, std::vector<char> &scratch) {
+      idx = lua_absindex(L, idx);
+
+      bool reserved = reserve_table_stack(L);
+      for (int attempt = 0; attempt < conversion_attempts; attempt++) {
+        uint64_t need = lua_type(L, idx) == LUA_TTABLE ? arena_bytes_of(L, idx, false, reserved) : 0;
+        if (need > scratch.size()) scratch.resize(need);
+
+        arena_sink sink { .cursor = scratch.data(), .end = scratch.data() + scratch.size(), .copy = false };
+        table_path path(reserved);
+        variant_t value = variant_from_lua_with(L, idx, sink, path);
+        if (!sink.overflowed) return value;
+      }
+
+      return nil_variant();
+    }
+
+    /**
+     * @brief Internal function : Converts `n` Lua values, starting at `first`, into a caller-owned frame.
+     * @param copy Whether strings and binaries are copied into the arena, or borrowed from Lua.
+     * @param pins Collects the nested strings borrowed, if not null.
+     * @param grow Called once if the frame is too small, before giving up. May be null.
+     * @return False when the frame is too small, or its values changed while being converted.
+     *         `frame.count` and `frame.arena_used` then hold the measured sizes.
+     */
+    static bool frame_from_lua(lua_State *L, int first, uint64_t n, varframe_t &frame, bool copy = true, table_pins *pins = nullptr,
+                               yumlibc_framegrow_type grow = nullptr, void *context = nullptr) {
+      bool reserved = reserve_table_stack(L);
+      uint64_t bytes = 0;
+      for (uint64_t i = 0; i < n; i++) bytes += arena_bytes_of(L, first + (int)i, copy, reserved);
 
-        default: return variant_t{.type = variant_t::VARIANT_NIL};
+      frame.count = n;
+      frame.arena_used = bytes;
+      if (n > frame.capacity || bytes > frame.arena_capacity) {
+        if (!grow || !grow(context, &frame)) return false;
+
+        frame.count = n;
+        frame.arena_used = bytes;
+        if (n > frame.capacity || bytes > frame.arena_capacity) return false;
+      }
+
+      arena_sink sink { .cursor = frame.arena, .end = frame.arena + frame.arena_capacity, .copy = copy };
+      for (uint64_t i = 0; i < n && !sink.overflowed; i++) {
+        table_path path(reserved);
+        path.pins = pins;
+        frame.values[i] = variant_from_lua_with(L, first + (int)i, sink, path);
       }
+
+      if (sink.overflowed) return false;
+
+      frame.arena_used = sink.cursor - frame.arena;
+      return true;
     }
 
     static void push_variant_to_lua(lua_State *L, const variant_t &var) {
@@ -120,6 +660,45 @@ namespace YumEngine::xV1 {
           lua_pushinteger(L, var.hold.uid.bytes);
           lua_settable(L, -3);
           break;
+        case variant_t::VARIANT_TABLE: {
+          const vartable_t *table = var.hold.table;
+          if (!table) { lua_pushnil(L); break; }
+
+          if (table->keys) {
+            lua_createtable(L, 0, (int)table->length);
+            for (uint64_t i = 0; i < table->length; i++) {
+              if (table->keys[i].type == variant_t::VARIANT_NIL) continue; // Lua tables have no nil keys.
+              push_variant_to_lua(L, table->keys[i]);
+              push_variant_to_lua(L, table->values[i]);
+              lua_rawset(L, -3);
+            }
+          } else {
+            lua_createtable(L, (int)table->length, 0);
+            for (uint64_t i = 0; i < table->length; i++) {
+              push_variant_to_lua(L, table->values[i]);
+              lua_rawseti(L, -2, (lua_Integer)(i + 1));
+            }
+          }
+          break;
+        }
+        case variant_t::VARIANT_INTEGER_ARRAY: {
+          const intarray_t &integers = var.hold.integers;
+          lua_createtable(L, (int)integers.length, 0);
+          for (uint64_t i = 0; i < integers.length; i++) {
+            lua_pushinteger(L, integers.start[i]);
+            lua_rawseti(L, -2, (lua_Integer)(i + 1));
+          }
+          break;
+        }
+        case variant_t::VARIANT_NUMBER_ARRAY: {
+          const numarray_t &numbers = var.hold.numbers;
+          lua_createtable(L, (int)numbers.length, 0);
+          for (uint64_t i = 0; i < numbers.length; i++) {
+            lua_pushnumber(L, numbers.start[i]);
+            lua_rawseti(L, -2, (lua_Integer)(i + 1));
+          }
+          break;
+        }
         default: lua_pushnil(L); break;
       }
     }
@@ -130,8 +709,6 @@ namespace YumEngine::xV1 {
       }
     }
 
-    thread_local std::unordered_map<std::string, yum_callback> _callbacks;
-
     static void dump_lua(lua_State *L) {
       utf8 code = "for k, v in pairs(_G) do"
                    "  print(k, v)"
@@ -139,31 +716,6 @@ namespace YumEngine::xV1 {
       luaL_dostring(L, code);
     }
 
-    static int static_lua_callback(lua_State* L) {
-      const char* cstrname = lua_tostring(L, lua_upvalueindex(1));
-      if (!cstrname) return 0;
-
-      auto it = _callbacks.find(cstrname);
-      if (it == _callbacks.end()) return 0;
-
-      int nargs = lua_gettop(L);
-      variant_t* arguments_from_lua = (variant_t*)yumalloc(sizeof(variant_t) * nargs);
-
-      for (int i = 0; i < nargs; i++) {
-        arguments_from_lua[i] = variant_from_lua(L, i + 1);
-      }
-
-      uint64_t outc;
-      variant_t* result = it->second(nargs, arguments_from_lua, &outc);
-      
-      push_vararray_to_lua(L, outc, result);
-      
-      yumfree((void*)arguments_from_lua);
-      yumfree((void*)result); // Yup, you may allocate returned values with yumalloc.
-      
-      return static_cast<int>(outc);
-    }
-
     void cd(lua_State *L, const Sdk::strview &view) {
       YUM_DEBUG_HERE
       lua_getglobal(L, "_G");
@@ -202,131 +754,1297 @@ namespace YumEngine::xV1 {
       YUM_DEBUG_PUTS(("(safe) walked at " + std::string(view.head(), view.length())).c_str())
     }
 
+    /** @brief Internal : Steady clock, in nanoseconds. */
+    inline uint64_t steady_ns() {
+      return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /** @brief Internal : Memory handed to lua_load in one piece. */
+    struct whole_chunk {
+      const char *data;
+      size_t      size;
+    };
+
+    const char *whole_chunk_reader(lua_State *, void *ud, size_t *size) {
+      whole_chunk *chunk = (whole_chunk*)ud;
+      *size = chunk->size;
+      chunk->size = 0;
+      return *size ? chunk->data : nullptr;
+    }
+
+    /** @brief Internal : Compiles memory without copying it, in a single read. */
+    int load_whole(lua_State *L, const char *data, size_t size, const char *chunkname) {
+      whole_chunk chunk = { data, size };
+      return lua_load(L, whole_chunk_reader, &chunk, chunkname, nullptr);
+    }
   }
 
   State::State() {
     YUM_DEBUG_HERE
     L = luaL_newstate();
+    *(State**)lua_getextraspace(L) = this; // Threads created later copy it.
   }
 
-  State::~State() {
-    lua_close(L);
+  static int panic_handler(lua_State *L) {
+    const char *msg = lua_tostring(L, -1);
+    fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n", msg ? msg : "error object is not a string");
+    return 0;
   }
 
-  void State::push_callback(utf8 name, const yum_callback &callback) {
+  State::State(const allocpolicy_t &policy)
+    : allocator(std::make_unique<Allocator>(policy)) {
     YUM_DEBUG_HERE
+    L = lua_newstate(Allocator::lua_alloc, allocator.get());
+    if (!L) throw std::bad_alloc();
 
-    if (!name) yumlibcxx_throw(expected a function name, syserr_t::NULL_OR_EMPTY_ARGUMENT, argument const lstring &name);
-    assert(lua_istable(L, -1));
-    
-    _static_units::_callbacks[name] = callback;
-    YUM_DEBUG_PUTS(std::string("pushed callback " + std::string(name)).c_str())
-    
-    int top_before = lua_gettop(L);
+    lua_atpanic(L, panic_handler);
+    *(State**)lua_getextraspace(L) = this;
+  }
 
-    lua_pushstring(L, name);
-    lua_pushcclosure(L, _static_units::static_lua_callback, 1);
-    lua_setfield(L, -2, name);
-    lua_settop(L, top_before);
-    
-    YUM_DEBUG_OUTF
+  memstats_t State::memory_stats() const {
+    busy_scope busy(this);
+    if (allocator) return allocator->stats();
+
+    uint64_t live = heap_bytes();
+    return memstats_t{ .live = live, .peak = live, .limit = 0, .allocations = 0, .failures = 0, .reserved = live };
   }
 
-  syserr_t State::call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, uint64_t& nargs, variant_t** out) {
-    YUM_DEBUG_HERE;
+  bool State::set_memory_limit(uint64_t limit) {
+    if (!allocator) return false;
 
-    nargs = 0;
+    allocator->set_limit(limit);
+    return true;
+  }
 
-    int top_before = lua_gettop(L);
+  State::~State() {
+    // Scheduler threads would otherwise go on collecting a closed State.
+    if (gc_scheduler) gc_scheduler->remove(*this);
+    stop_profiler();
+    lua_close(L);
+  }
 
-    // Push function onto stack
-    _static_units::cd(L, Sdk::strview(path, pathlen));
-    YUM_DEBUG_HERE
+  int State::dispatch_callback(lua_State *L) {
+    State *state = *(State**)lua_getextraspace(L);
+    uint64_t index = (uint64_t)lua_tointeger(L, lua_upvalueindex(1));
+    uint32_t generation = (uint32_t)lua_tointeger(L, lua_upvalueindex(2));
 
-    if (!lua_isfunction(L, -1)) {
-      lua_settop(L, top_before);
-      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    if (index >= state->callbacks.size() || state->callbacks[index].generation != generation) {
+      return luaL_error(L, "called a host callback that was removed");
     }
 
-    // Push args AFTER function is already at stack top
-    _static_units::push_vararray_to_lua(L, argc, args);
+    if (state->replay) [[unlikely]] return replay_callback(L, state, index);
 
-    // Call
-    YUM_DEBUG_PUTS("calling lua function")
-    if (lua_pcall(L, argc, LUA_MULTRET, 0) != LUA_OK) {
-      std::string msg = lua_tostring(L, -1);
-      msg += "* when calling: `" + std::string(path) + "`";
+    // The callback may push other callbacks, which may move the slots.
+    callback_slot slot = state->callbacks[index];
+    if (slot.fastcallback) return dispatch_fastcallback(L, state, slot, index);
+    if (!slot.callback && !slot.ctxcallback) return luaL_error(L, "called a host callback that was removed");
 
-      lua_settop(L, top_before);
+    uint64_t start = state->stats || Tracer::on(YUM_TRACE_CALLBACKS) ? Tracer::now() : 0;
+    PerfCounters::sample counted;
+    bool counting = state->stats && state->stats->counts_hardware() && PerfCounters::read(counted);
 
-      return syserr_t{
-        .category = syserr_t::LUA_EXECUTION_ERROR,
-        .source   = { .file = lstring_from_string(__FILE__),
-                      .func = lstring_from_string(__func__),
-                      .line = __LINE__ },
-        .comment  = cxxstring2lstring(msg)
-      };
+    int nargs = lua_gettop(L);
+    variant_t* arguments_from_lua = (variant_t*)yumalloc(sizeof(variant_t) * nargs);
+
+    for (int i = 0; i < nargs; i++) {
+      arguments_from_lua[i] = _static_units::variant_from_lua(L, i + 1);
     }
 
-    // Calculate returned values
-    int top_after = lua_gettop(L);
-    nargs = top_after - top_before;
-    YUM_DEBUG_PUTS("translating args")
-    if (nargs > 0) {
-      YUM_DEBUG_HERE
-      (*out) = (variant_t*)yumalloc(nargs * sizeof(variant_t));
-      YUM_DEBUG_HERE
-      int first_ret = top_after - nargs + 1;
-      YUM_DEBUG_HERE
-      for (uint64_t i = 0; i < nargs; ++i) {
-        (*out)[i] = _static_units::variant_from_lua(L, first_ret + i);
+    uint64_t exec_start = start ? Tracer::now() : 0;
+
+    uint64_t outc = 0;
+    variant_t* result = slot.callback 
+                      ? slot.callback(nargs, arguments_from_lua, &outc)
+                      : slot.ctxcallback(slot.context, nargs, arguments_from_lua, &outc);
+    
+    uint64_t exec_end = start ? Tracer::now() : 0;
+
+    if (state->recorder) state->recorder->callback_return(state->callback_names[index], outc, result);
+    _static_units::push_vararray_to_lua(L, outc, result);
+    
+    yumfree((void*)arguments_from_lua);
+    yumfree((void*)result); // Yup, you may allocate returned values with yumalloc.
+
+    // The callback may have changed the stats, or removed itself.
+    if (start && state->callbacks[index].generation == generation) {
+      if (state->stats) {
+        if (counting) counting = PerfCounters::since(counted);
+        uint64_t end = Tracer::now();
+        state->stats->record(CallStats::HOST_CALLBACK, state->callback_names[index], false, (exec_start - start) + (end - exec_end), exec_end - exec_start, 
+                             counting ? &counted : nullptr);
       }
-    }
 
-    lua_settop(L, top_before);
-    YUM_DEBUG_OUTF
-    return yumsuccess;
+      YUM_TRACE_COMPLETE(YUM_TRACE_CALLBACKS, "callback", start, state->callback_names[index])
+    }
+    
+    return static_cast<int>(outc);
   }
 
-  void State::push_variant(utf8 name, const variant_t &var) {
-    _static_units::push_variant_to_lua(L, var);
+  int State::dispatch_fastcallback(lua_State *L, State *state, const callback_slot &slot, uint64_t index) {
+    uint64_t start = state->stats || Tracer::on(YUM_TRACE_CALLBACKS) ? Tracer::now() : 0;
+    uint32_t generation = slot.generation;
+    PerfCounters::sample counted;
+    bool counting = state->stats && state->stats->counts_hardware() && PerfCounters::read(counted);
+
+    if (state->callback_depth >= state->callback_frames.size()) {
+      auto frame = std::make_unique<callback_frame>();
+      frame->arguments.resize(8);
+      frame->values.resize(16);
+      frame->arena.resize(1024);
+      state->callback_frames.push_back(std::move(frame));
+    }
+
+    // Frames are per nesting level: a callback calling Lua calling a callback gets the next one.
+    callback_frame &frame = *state->callback_frames[state->callback_depth++];
+
+    uint64_t nargs = (uint64_t)lua_gettop(L);
+    varframe_t arguments{};
+    for (int attempt = 0;; attempt++) {
+      if (attempt > _static_units::conversion_attempts) {
+        state->callback_depth--;
+        return luaL_error(L, "host callback arguments changed while being read");
+      }
+
+      arguments = varframe_t{ 
+        .values = frame.arguments.data(), .capacity = frame.arguments.size(), .count = 0, 
+        .arena = frame.tables.data(), .arena_capacity = frame.tables.size(), .arena_used = 0 
+      };
+
+      if (_static_units::frame_from_lua(L, 1, nargs, arguments, false)) break;
+      if (arguments.count > frame.arguments.size()) frame.arguments.resize(arguments.count);
+      if (arguments.arena_used > frame.tables.size()) frame.tables.resize(arguments.arena_used);
+    }
+
+    varframe_t out{ 
+      .values = frame.values.data(), .capacity = frame.values.size(), .count = 0,
+      .arena = frame.arena.data(), .arena_capacity = frame.arena.size(), .arena_used = 0
+    };
+
+    uint64_t exec_start = start ? Tracer::now() : 0;
+    boolean_t succeeded = slot.fastcallback(slot.context, nargs, arguments.values, &out);
+    uint64_t exec_end = start ? Tracer::now() : 0;
+    state->callback_depth--;
+
+    bool failed = !succeeded || out.count > out.capacity;
+    if (start && state->callbacks[index].generation == generation) {
+      // Pushing the returned values is left out: recorded before, as a failure raises an error instead.
+      if (state->stats) {
+        if (counting) counting = PerfCounters::since(counted);
+        state->stats->record(CallStats::HOST_CALLBACK, state->callback_names[index], failed, exec_start - start, exec_end - exec_start, 
+                             counting ? &counted : nullptr);
+      }
+      YUM_TRACE_COMPLETE(YUM_TRACE_CALLBACKS, "callback", start, state->callback_names[index], failed)
+    }
+
+    if (failed) {
+      if (succeeded) lua_pushliteral(L, "host callback returned more values than its frame holds");
+      else if (out.count > 0 && out.values[0].type == variant_t::VARIANT_STRING) {
+        lua_pushlstring(L, out.values[0].hold.lstring.start, out.values[0].hold.lstring.length);
+      } else lua_pushliteral(L, "host callback failed");
+      return lua_error(L);
+    }
+
+    if (!lua_checkstack(L, (int)out.count)) return luaL_error(L, "host callback returned too many values");
+    if (state->recorder) state->recorder->callback_return(state->callback_names[index], out.count, out.values);
+    _static_units::push_vararray_to_lua(L, out.count, out.values);
+    return static_cast<int>(out.count);
+  }
+
+  int State::replay_callback(lua_State *L, State *state, uint64_t index) {
+    uint64_t count = 0;
+    const variant_t *values = nullptr;
+    state->replay->next_return(state->callback_names[index], count, values);
+
+    if (!lua_checkstack(L, (int)count)) return luaL_error(L, "recorded callback returned too many values");
+    _static_units::push_vararray_to_lua(L, count, values);
+    return static_cast<int>(count);
+  }
+
+  int State::pcall(int nargs, int nresults) {
+    // An error unwinds through callbacks without returning to them: their frames are free again.
+    uint64_t depth = callback_depth;
+
+    // Budgets and interrupts belong to the outermost call. Calls from callbacks share them.
+    bool outermost = call_depth++ == 0;
+    std::optional<hook_limit> limit;
+
+    if (outermost) {
+      budget_tripped = false;
+      running_thread.store(L, std::memory_order_release);
+
+      if (budget.instructions || budget.time_us) {
+        limit.emplace(L, budget.instructions, budget.time_us);
+        active_budget = &*limit;
+        rehook(L, active_budget);
+      }
+
+      // Interrupted while the call was being prepared: no hook was there to see it.
+      if (interrupt_requested.load(std::memory_order_relaxed) && !lua_gethook(L)) lua_sethook(L, count_hook, LUA_MASKCOUNT, 1);
+    }
+
+    int status = lua_pcall(L, nargs, nresults, 0);
+
+    if (outermost) {
+      running_thread.store(nullptr, std::memory_order_release);
+      if (active_budget) {
+        active_budget = nullptr;
+        rehook(L, nullptr);
+      }
+    }
+
+    call_depth--;
+    callback_depth = depth;
+    return status;
+  }
+
+  void State::rehook(lua_State *thread, const hook_limit *limit) {
+    // Time sampling polls the timer's flag every `time_sampling_count` instructions.
+    constexpr int time_sampling_count = 100;
+
+    int count = limit ? limit->count : 0;
+    if (profiling) {
+      int profile_count = profile_mode == YUM_PROFILE_TIME
+        ? time_sampling_count
+        : (int)std::min<uint64_t>(std::max<uint64_t>(profile_period, 1), INT32_MAX);
+
+      count = count ? std::min(count, profile_count) : profile_count;
+    }
+
+    if (count) lua_sethook(thread, count_hook, LUA_MASKCOUNT, count);
+    else lua_sethook(thread, nullptr, 0, 0);
+  }
+
+  void State::start_profiler(profmode_t mode, uint64_t period) {
+    busy_scope busy(this);
+    stop_profiler();
+
+    profiling = true;
+    profile_mode = mode;
+    profile_period = std::max<uint64_t>(period, 1);
+    profile_countdown = (int64_t)profile_period;
+    rehook(L, nullptr);
+
+    if (mode == YUM_PROFILE_TIME) {
+      profile_timer_stop.store(false);
+      profile_timer = std::thread([this, period = profile_period] {
+        while (!profile_timer_stop.load(std::memory_order_relaxed)) {
+          std::this_thread::sleep_for(std::chrono::microseconds(period));
+          sample_due.store(true, std::memory_order_relaxed);
+        }
+      });
+    }
+  }
+
+  void State::stop_profiler() {
+    busy_scope busy(this);
+    if (!profiling) return;
+
+    profiling = false;
+    if (profile_timer.joinable()) {
+      profile_timer_stop.store(true);
+      profile_timer.join();
+    }
+
+    sample_due.store(false);
+    rehook(L, nullptr);
+  }
+
+  void State::reset_profile() {
+    busy_scope busy(this);
+    profiler.reset();
+  }
+
+  void State::use_call_stats(std::shared_ptr<CallStats> stats) {
+    this->stats = std::move(stats);
+  }
+
+  void State::record_calls(std::shared_ptr<CallRecorder> recorder) {
+    this->recorder = std::move(recorder);
+  }
+
+  utf8 State::handle_path(const fnhandle_t &handle) const {
+    auto it = handle_paths.find(handle.function);
+    return it == handle_paths.end() ? "<resolved handle>" : it->second.c_str();
+  }
+
+  State::call_record::call_record(State *state, std::string_view name, uint64_t argc, const variant_t *args)
+    : stats(state->stats.get()), recorder(state->recorder.get()), name(name), argc(argc), args(args),
+      start(stats || recorder || Tracer::on(YUM_TRACE_CALLS) ? Tracer::now() : 0) {
+    if (stats && stats->counts_hardware()) counting = PerfCounters::read(counted);
+  }
+
+  void State::call_record::executing() {
+    if (start) exec_start = Tracer::now();
+  }
+
+  void State::call_record::executed() {
+    if (start) exec_end = Tracer::now();
+  }
+
+  void State::call_record::finish(bool failed) {
+    if (!start) return;
+    if (counting) counting = PerfCounters::since(counted);
+    uint64_t end = Tracer::now();
+    if (stats) stats->record(CallStats::LUA_PATH, name, failed, (exec_start - start) + (end - exec_end), exec_end - exec_start, counting ? &counted : nullptr);
+    if (recorder) recorder->call(name, argc, args, start, end - start, failed);
+
+    YUM_TRACE_COMPLETE(YUM_TRACE_CALLS, "call", start, name, failed)
+  }
+
+  decltype(syserr_t::category) State::failure_category(int status) const {
+    if (budget_tripped) return syserr_t::BUDGET_EXCEEDED;
+    return status == LUA_ERRMEM ? syserr_t::OUT_OF_MEMORY : syserr_t::LUA_EXECUTION_ERROR;
+  }
+
+  void State::set_call_budget(const callbudget_t &budget) {
+    this->budget = budget;
+  }
+
+  callbudget_t State::call_budget() const {
+    return budget;
+  }
+
+  void State::interrupt() {
+    interrupt_requested.store(true, std::memory_order_relaxed);
+
+    // lua_sethook may be called asynchronously. A hook already there (budget, slice) sees the request soon enough,
+    // and keeps its count. Otherwise the hook runs at the next instruction of the running thread.
+    lua_State *thread = running_thread.load(std::memory_order_acquire);
+    if (thread && !lua_gethook(thread)) lua_sethook(thread, count_hook, LUA_MASKCOUNT, 1);
+  }
+
+  uint64_t State::register_callback(utf8 name, const callback_slot &slot) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    if (!name) yumlibcxx_throw(expected a function name, syserr_t::NULL_OR_EMPTY_ARGUMENT, argument const lstring &name);
+    assert(lua_istable(L, -1));
+
+    uint64_t index;
+    if (free_callbacks.empty()) {
+      index = callbacks.size();
+      callbacks.push_back(slot);
+      callback_names.emplace_back(name);
+    } else {
+      index = free_callbacks.back();
+      free_callbacks.pop_back();
+
+      uint32_t generation = callbacks[index].generation;
+      callbacks[index] = slot;
+      callbacks[index].generation = generation;
+      callback_names[index] = name;
+    }
+    YUM_DEBUG_PUTS(std::string("pushed callback " + std::string(name)).c_str())
+    if (recorder) recorder->text(CallRecorder::CALLBACK, name);
+    
+    int top_before = lua_gettop(L);
+
+    lua_pushinteger(L, (lua_Integer)index);
+    lua_pushinteger(L, (lua_Integer)callbacks[index].generation);
+    lua_pushcclosure(L, dispatch_callback, 2);
+    lua_setfield(L, -2, name);
+    lua_settop(L, top_before);
+    
+    YUM_DEBUG_OUTF
+    return ((uint64_t)callbacks[index].generation << 32) | index;
+  }
+
+  uint64_t State::push_callback(utf8 name, const yum_callback &callback) {
+    return register_callback(name, callback_slot{ .callback = callback, .ctxcallback = nullptr, .fastcallback = nullptr, .context = nullptr, .generation = 0 });
+  }
+
+  uint64_t State::push_callback(utf8 name, const yum_ctxcallback &callback, void *context) {
+    return register_callback(name, callback_slot{ .callback = nullptr, .ctxcallback = callback, .fastcallback = nullptr, .context = context, .generation = 0 });
+  }
+
+  uint64_t State::push_callback(utf8 name, const yum_fastcallback &callback, void *context) {
+    return register_callback(name, callback_slot{ .callback = nullptr, .ctxcallback = nullptr, .fastcallback = callback, .context = context, .generation = 0 });
+  }
+
+  void State::remove_callback(uint64_t id) {
+    uint64_t index = id & 0xFFFFFFFF;
+    uint32_t generation = (uint32_t)(id >> 32);
+
+    if (index >= callbacks.size() || callbacks[index].generation != generation) return;
+
+    // Closures still in Lua see another generation, and raise an error when called.
+    callbacks[index] = callback_slot{ .callback = nullptr, .ctxcallback = nullptr, .fastcallback = nullptr, .context = nullptr, .generation = generation + 1 };
+    free_callbacks.push_back(index);
+  }
+
+  bool State::rebind_callback(uint64_t id, void *context) {
+    uint64_t index = id & 0xFFFFFFFF;
+    uint32_t generation = (uint32_t)(id >> 32);
+
+    if (index >= callbacks.size() || callbacks[index].generation != generation) return false;
+    if (!callbacks[index].ctxcallback && !callbacks[index].fastcallback) return false;
+
+    callbacks[index].context = context;
+    return true;
+  }
+
+  syserr_t State::call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, uint64_t& nargs, variant_t** out) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE;
+
+    nargs = 0;
+
+    call_record record(this, std::string_view(path, pathlen), argc, args);
+    int top_before = lua_gettop(L);
+
+    // Push function onto stack
+    _static_units::cd(L, Sdk::strview(path, pathlen));
+    YUM_DEBUG_HERE
+
+    if (!lua_isfunction(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    return invoke(top_before, path, argc, args, nargs, out, record);
+  }
+
+  syserr_t State::call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, varframe_t &frame, yumlibc_framegrow_type grow, void *context) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    frame.count = 0;
+
+    call_record record(this, std::string_view(path, pathlen), argc, args);
+    int top_before = lua_gettop(L);
+
+    _static_units::cd(L, Sdk::strview(path, pathlen));
+
+    if (!lua_isfunction(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    return invoke(top_before, path, argc, args, frame, record, grow, context);
+  }
+
+  syserr_t State::call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, varframe_t &frame, callscope_t &scope) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    frame.count = 0;
+    frame.arena_used = 0;
+
+    call_record record(this, std::string_view(path, pathlen), argc, args);
+    int top_before = lua_gettop(L);
+    scope = callscope_t{ .pin = LUA_NOREF, .count = 0 };
+
+    _static_units::cd(L, Sdk::strview(path, pathlen));
+
+    if (!lua_isfunction(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    syserr_t err = execute(top_before, path, argc, args, record);
+    if (err.category != err.OK) return err;
+
+    int top_after = lua_gettop(L);
+    int count = top_after - top_before;
+    if (count == 0) {
+      lua_settop(L, top_before);
+      record.finish(false);
+      YUM_DEBUG_OUTF
+      return err;
+    }
+
+    // Returned values go to a registry table, pinning borrowed memory until the scope is released.
+    // Nested strings are pinned on their own: the tables holding them may change meanwhile.
+    if (free_pins.empty()) {
+      lua_createtable(L, count, 0);
+      scope.pin = luaL_ref(L, LUA_REGISTRYINDEX);
+    } else {
+      scope.pin = free_pins.back();
+      free_pins.pop_back();
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, scope.pin);
+    _static_units::table_pins pins{ .table = lua_gettop(L) };
+    for (int i = 0; i < count; i++) pins.pin(L, top_before + 1 + i);
+
+    bool fits = _static_units::frame_from_lua(L, top_before + 1, count, frame, false, &pins);
+    scope.count = (int32_t)pins.count;
+    lua_settop(L, top_before);
+
+    if (!fits) {
+      release(scope);
+      record.finish(true);
+      return yummakeerror_runtime("Returned values do not fit in the frame (see count and arena_used)", syserr_t::BUFFER_OVERFLOW);
+    }
+
+    record.finish(false);
+    YUM_DEBUG_OUTF
+    return err;
+  }
+
+  syserr_t State::call(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, yumlibc_visitor_type visitor, void *context) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    call_record record(this, std::string_view(path, pathlen), argc, args);
+    int top_before = lua_gettop(L);
+
+    _static_units::cd(L, Sdk::strview(path, pathlen));
+
+    if (!lua_isfunction(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    syserr_t err = execute(top_before, path, argc, args, record);
+    if (err.category != err.OK) return err;
+
+    // A visitor calling a visiting call gets the next scratch: its tables stay untouched.
+    if (visit_depth >= scratches.size()) scratches.push_back(std::make_unique<std::vector<char>>());
+    std::vector<char> &scratch = *scratches[visit_depth++];
+
+    int top_after = lua_gettop(L);
+    for (int i = top_before + 1; i <= top_after; i++) {
+      variant_t value = _static_units::variant_borrowed_from_lua(L, i, scratch);
+      if (!visitor(context, (uint64_t)(i - top_before - 1), &value)) break;
+    }
+
+    visit_depth--;
+    lua_settop(L, top_before);
+    record.finish(false);
+    YUM_DEBUG_OUTF
+    return err;
+  }
+
+  void State::release(callscope_t &scope) {
+    busy_scope busy(this);
+    if (scope.count <= 0) return;
+
+    // Emptied, so that the values can be collected, and kept for the next borrowing call.
+    lua_rawgeti(L, LUA_REGISTRYINDEX, scope.pin);
+    for (int i = 1; i <= scope.count; i++) {
+      lua_pushnil(L);
+      lua_rawseti(L, -2, i);
+    }
+    lua_pop(L, 1);
+
+    free_pins.push_back(scope.pin);
+    scope = callscope_t{ .pin = LUA_NOREF, .count = 0 };
+  }
+
+  syserr_t State::resolve(utf8 path, uint64_t pathlen, fnhandle_t &handle) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    handle = fnhandle_t{ .function = LUA_NOREF, .chain = LUA_NOREF, .key = LUA_NOREF };
+
+    int top_before = lua_gettop(L);
+    Sdk::strview view(path, pathlen);
+    uint64_t dot = view.rfind('.');
+
+    // Anchor every table on the path as [_G, key1, table1, key2, table2, ...]
+    lua_createtable(L, 8, 0);
+    int chain = lua_gettop(L);
+    int slot = 1;
+    bool broken = false;
+
+    lua_getglobal(L, "_G");
+    lua_pushvalue(L, -1);
+    lua_rawseti(L, chain, slot);
+
+    if (dot != view.length()) {
+      Sdk::strview(path, dot).split('.', [&](Sdk::strview key_view) {
+        if (broken) return;
+
+        lua_pushlstring(L, key_view.head(), key_view.length());
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, chain, ++slot);
+        lua_gettable(L, -2);
+        lua_remove(L, -2);
+
+        if (!lua_istable(L, -1)) {
+          broken = true;
+          return;
+        }
+
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, chain, ++slot);
+      });
+    }
+
+    if (broken || !lua_istable(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Function owner is not a table", syserr_t::NOT_A_TABLE);
+    }
+
+    if (dot == view.length()) lua_pushlstring(L, path, pathlen);
+    else                      lua_pushlstring(L, path + dot + 1, pathlen - dot - 1);
+
+    lua_pushvalue(L, -1);
+    lua_gettable(L, -3); // stack: [chain, owner, key, function]
+
+    if (!lua_isfunction(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    handle.function = luaL_ref(L, LUA_REGISTRYINDEX);
+    handle.key      = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_pop(L, 1);
+    handle.chain    = luaL_ref(L, LUA_REGISTRYINDEX);
+    handle_paths[handle.function].assign(path, pathlen);
+
+    lua_settop(L, top_before);
+    YUM_DEBUG_OUTF
+    return yumsuccess;
+  }
+
+  bool State::push_handle(const fnhandle_t &handle) {
+    if (handle.function <= 0 || handle.chain <= 0 || handle.key <= 0) return false;
+
+    int top_before = lua_gettop(L);
+    int chain = top_before + 1;
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, handle.chain);
+    lua_rawgeti(L, chain, 1);
+    lua_getglobal(L, "_G"); // stack: [chain, anchored _G, current _G]
+    bool valid = lua_rawequal(L, -1, -2);
+    lua_pop(L, 1);
+
+    // Every table on the path must still be the one that was resolved
+    lua_Integer slots = static_cast<lua_Integer>(lua_rawlen(L, chain));
+    for (lua_Integer slot = 2; valid && slot < slots; slot += 2) {
+      lua_rawgeti(L, chain, slot);
+      lua_gettable(L, -2);
+      lua_rawgeti(L, chain, slot + 1); // stack: [chain, parent, current, anchored]
+      valid = lua_rawequal(L, -1, -2);
+      lua_pop(L, 1);
+      lua_remove(L, -2);
+    }
+
+    if (valid) {
+      lua_rawgeti(L, LUA_REGISTRYINDEX, handle.key);
+      lua_gettable(L, -2);
+      lua_rawgeti(L, LUA_REGISTRYINDEX, handle.function); // stack: [chain, owner, current, function]
+      valid = lua_rawequal(L, -1, -2);
+    }
+
+    if (!valid) {
+      lua_settop(L, top_before);
+      return false;
+    }
+
+    lua_replace(L, chain);
+    lua_settop(L, chain);
+    return true;
+  }
+
+  syserr_t State::call(const fnhandle_t &handle, uint64_t argc, const variant_t* args, uint64_t& nargs, variant_t** out) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    nargs = 0;
+
+    call_record record(this, "<resolved handle>", argc, args);
+    if (record.start) record.name = handle_path(handle);
+    int top_before = lua_gettop(L);
+
+    if (!push_handle(handle)) {
+      return yummakeerror_runtime("Function handle is released or its path got reassigned", syserr_t::INVALID_HANDLE);
+    }
+
+    return invoke(top_before, "<resolved handle>", argc, args, nargs, out, record);
+  }
+
+  syserr_t State::call_batch(utf8 path, uint64_t pathlen, uint64_t count, uint64_t argc, const variant_t* args, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t& nfailed) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    nfailed = 0;
+
+    int top_before = lua_gettop(L);
+
+    _static_units::cd(L, Sdk::strview(path, pathlen));
+
+    if (!lua_isfunction(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    return invoke_batch(path, count, argc, args, outc, out, errors, nfailed);
+  }
+
+  syserr_t State::call_batch(const fnhandle_t &handle, uint64_t count, uint64_t argc, const variant_t* args, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t& nfailed) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    nfailed = 0;
+
+    if (!push_handle(handle)) {
+      return yummakeerror_runtime("Function handle is released or its path got reassigned", syserr_t::INVALID_HANDLE);
+    }
+
+    return invoke_batch(handle_path(handle), count, argc, args, outc, out, errors, nfailed);
+  }
+
+  syserr_t State::invoke_batch(utf8 what, uint64_t count, uint64_t argc, const variant_t* args, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t& nfailed) {
+    static const syserr_t succeeded = yumsuccess;
+
+    int function = lua_gettop(L);
+
+    if (!lua_checkstack(L, (int)(argc + outc + 1))) {
+      lua_settop(L, function - 1);
+      return yummakeerror_runtime("Too many arguments or returned values for the Lua stack", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    for (uint64_t i = 0; i < count; i++) {
+      variant_t *results = out + i * outc;
+
+      // An interrupt stops the whole batch: the items left are not run.
+      if (interrupt_requested.load(std::memory_order_relaxed)) [[unlikely]] {
+        for (uint64_t j = i; j < count; j++) {
+          for (uint64_t k = 0; k < outc; k++) out[j * outc + k] = _static_units::nil_variant();
+          if (errors) errors[j] = yummakeerror_runtime("Batch interrupted before this item", syserr_t::BUDGET_EXCEEDED);
+        }
+
+        nfailed += count - i;
+        break;
+      }
+
+      call_record record(this, what, argc, args + i * argc);
+
+      lua_pushvalue(L, function);
+      _static_units::push_vararray_to_lua(L, argc, args + i * argc);
+
+      record.executing();
+      int status = pcall((int)argc, (int)outc);
+      record.executed();
+
+      if (status != LUA_OK) {
+        record.finish(true);
+        nfailed++;
+
+        for (uint64_t j = 0; j < outc; j++) results[j] = _static_units::nil_variant();
+
+        if (errors) {
+          std::string msg = lua_isstring(L, -1) ? lua_tostring(L, -1) : "(error object is not a string)";
+          msg += "* when calling: `" + std::string(what) + "` (batch item #" + std::to_string(i) + ")";
+
+          errors[i] = syserr_t{
+            .category = failure_category(status),
+            .source   = { .func = lstring_from_string(__func__),
+                          .file = lstring_from_string(__FILE__),
+                          .line = __LINE__ },
+            .comment  = cxxstring2lstring(msg)
+          };
+        }
+
+        lua_settop(L, function);
+        continue;
+      }
+
+      for (uint64_t j = 0; j < outc; j++) {
+        results[j] = _static_units::variant_from_lua(L, function + 1 + (int)j);
+      }
+
+      if (errors) errors[i] = succeeded;
+      lua_settop(L, function);
+      record.finish(false);
+    }
+
+    lua_settop(L, function - 1);
+    YUM_DEBUG_OUTF
+    return yumsuccess;
+  }
+
+  syserr_t State::call(const fnhandle_t &handle, uint64_t argc, const variant_t* args, varframe_t &frame, yumlibc_framegrow_type grow, void *context) {
+    busy_scope busy(this);
+    YUM_DEBUG_HERE
+
+    frame.count = 0;
+
+    call_record record(this, "<resolved handle>", argc, args);
+    if (record.start) record.name = handle_path(handle);
+    int top_before = lua_gettop(L);
+
+    if (!push_handle(handle)) {
+      return yummakeerror_runtime("Function handle is released or its path got reassigned", syserr_t::INVALID_HANDLE);
+    }
+
+    return invoke(top_before, "<resolved handle>", argc, args, frame, record, grow, context);
+  }
+
+  void State::release(fnhandle_t &handle) {
+    busy_scope busy(this);
+    handle_paths.erase(handle.function);
+    luaL_unref(L, LUA_REGISTRYINDEX, handle.function);
+    luaL_unref(L, LUA_REGISTRYINDEX, handle.chain);
+    luaL_unref(L, LUA_REGISTRYINDEX, handle.key);
+    handle = fnhandle_t{ .function = LUA_NOREF, .chain = LUA_NOREF, .key = LUA_NOREF };
+  }
+
+  State::hook_limit::hook_limit(lua_State *thread, uint64_t instructions, uint64_t time_us)
+    : thread(thread), instructions(instructions), executed(0),
+      deadline_ns(time_us ? _static_units::steady_ns() + time_us * 1000 : 0) {
+    // The clock is read every `granularity` instructions when a time limit is set.
+    constexpr uint64_t granularity = 1000;
+    count = (int)std::min<uint64_t>(instructions ? instructions : granularity, time_us ? granularity : INT32_MAX);
+  }
+
+  bool State::hook_limit::spent(int count) {
+    executed += (uint64_t)count;
+    return (instructions && executed >= instructions) || (deadline_ns && _static_units::steady_ns() >= deadline_ns);
+  }
+
+  void State::count_hook(lua_State *L, lua_Debug *) {
+    State *state = *(State**)lua_getextraspace(L);
+    int count = lua_gethookcount(L);
+
+    if (state->profiling) {
+      bool due = state->profile_mode == YUM_PROFILE_TIME
+        ? state->sample_due.exchange(false, std::memory_order_relaxed)
+        : (state->profile_countdown -= count) <= 0;
+
+      if (due) {
+        if (state->profile_mode == YUM_PROFILE_INSTRUCTIONS) state->profile_countdown += (int64_t)state->profile_period;
+        state->profiler.sample(L);
+      }
+    }
+
+    // Raised again at every instruction until the call unwinds, so that scripts cannot swallow it with pcall.
+    if (state->interrupt_requested.load(std::memory_order_relaxed)) {
+      state->budget_tripped = true;
+      luaL_error(L, "call interrupted");
+    }
+
+    if (state->active_budget && state->active_budget->spent(count)) {
+      state->budget_tripped = true;
+      state->active_budget->executed = state->active_budget->instructions; // Stays spent.
+      luaL_error(L, "call exceeded its budget");
+    }
+
+    // Coroutines created by a task inherit its hook: only the task itself is preempted.
+    hook_limit *slice = state->current_slice;
+    if (slice && slice->thread == L && slice->spent(count) && lua_isyieldable(L)) {
+      lua_yield(L, 0);
+    }
+
+    // Left by an interrupt that arrived after its call, or inherited by a coroutine that has no limit.
+    if (!state->profiling && !state->active_budget && (!slice || slice->thread != L)) {
+      lua_sethook(L, nullptr, 0, 0);
+    }
+  }
+
+  syserr_t State::start_task(utf8 what, uint64_t argc, const variant_t* args, const timeslice_t &slice, taskhandle_t &task, boolean_t &done, uint64_t &nargs, variant_t **out) {
+    pooled_thread pooled;
+    if (idle_threads.empty()) {
+      pooled.thread = lua_newthread(L);
+      pooled.ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    } else {
+      pooled = idle_threads.back();
+      idle_threads.pop_back();
+    }
+
+    lua_xmove(L, pooled.thread, 1); // The function.
+    _static_units::push_vararray_to_lua(pooled.thread, argc, args);
+
+    uint32_t index;
+    if (free_tasks.empty()) {
+      index = (uint32_t)tasks.size();
+      tasks.emplace_back();
+    } else {
+      index = free_tasks.back();
+      free_tasks.pop_back();
+    }
+
+    task_slot &slot = tasks[index];
+    slot.thread = pooled.thread;
+    slot.ref    = pooled.ref;
+    slot.nargs  = (int)argc;
+    slot.active = true;
+    slot.what   = what;
+
+    task = taskhandle_t{ .index = index, .generation = slot.generation };
+    return resume(task, slice, done, nargs, out);
+  }
+
+  void State::finish_task(uint32_t index, bool reset) {
+    task_slot &slot = tasks[index];
+    lua_sethook(slot.thread, nullptr, 0, 0);
+
+    if (reset) {
+#if LUA_VERSION_RELEASE_NUM >= 50406
+      lua_closethread(slot.thread, L);
+#else
+      lua_resetthread(slot.thread);
+#endif
+    }
+
+    lua_settop(slot.thread, 0);
+
+    constexpr uint64_t max_idle_threads = 64;
+    if (idle_threads.size() < max_idle_threads) idle_threads.push_back(pooled_thread{ .thread = slot.thread, .ref = slot.ref });
+    else luaL_unref(L, LUA_REGISTRYINDEX, slot.ref);
+
+    slot.thread = nullptr;
+    slot.ref    = LUA_NOREF;
+    slot.active = false;
+    slot.generation++;
+    slot.what.clear();
+    free_tasks.push_back(index);
+  }
+
+  syserr_t State::call_async(utf8 path, uint64_t pathlen, uint64_t argc, const variant_t* args, const timeslice_t &slice, taskhandle_t &task, boolean_t &done, uint64_t& nargs, variant_t **out) {
+    busy_scope busy(this);
+    done = false;
+    nargs = 0;
+
+    int top_before = lua_gettop(L);
+    _static_units::cd(L, Sdk::strview(path, pathlen));
+
+    if (!lua_isfunction(L, -1)) {
+      lua_settop(L, top_before);
+      return yummakeerror_runtime("Not a Lua function", syserr_t::LUA_EXECUTION_ERROR);
+    }
+
+    return start_task(path, argc, args, slice, task, done, nargs, out);
+  }
+
+  syserr_t State::call_async(const fnhandle_t &handle, uint64_t argc, const variant_t* args, const timeslice_t &slice, taskhandle_t &task, boolean_t &done, uint64_t& nargs, variant_t **out) {
+    busy_scope busy(this);
+    done = false;
+    nargs = 0;
+
+    if (!push_handle(handle)) {
+      return yummakeerror_runtime("Function handle is released or its path got reassigned", syserr_t::INVALID_HANDLE);
+    }
+
+    return start_task(handle_path(handle), argc, args, slice, task, done, nargs, out);
+  }
+
+  syserr_t State::resume(const taskhandle_t &task, const timeslice_t &slice, boolean_t &done, uint64_t& nargs, variant_t **out) {
+    busy_scope busy(this);
+    done = false;
+    nargs = 0;
+
+    if (task.index >= tasks.size() || !tasks[task.index].active || tasks[task.index].generation != task.generation) {
+      return yummakeerror_runtime("Task handle is no longer valid", syserr_t::INVALID_HANDLE);
+    }
+
+    lua_State *thread = tasks[task.index].thread;
+    int narg = std::exchange(tasks[task.index].nargs, 0);
+
+    hook_limit limit(thread, slice.instructions, slice.time_us);
+    rehook(thread, slice.instructions || slice.time_us ? &limit : nullptr);
+
+    hook_limit *previous = std::exchange(current_slice, &limit);
+    uint64_t depth = callback_depth;
+
+    bool outermost = call_depth++ == 0;
+    if (outermost) {
+      budget_tripped = false;
+      running_thread.store(thread, std::memory_order_release);
+      if (interrupt_requested.load(std::memory_order_relaxed) && !lua_gethook(thread)) lua_sethook(thread, count_hook, LUA_MASKCOUNT, 1);
+    }
+
+    uint64_t start = Tracer::on(YUM_TRACE_TASKS) ? Tracer::now() : 0;
+    int nres = 0;
+    int status = lua_resume(thread, L, narg, &nres);
+    if (start) Tracer::complete(YUM_TRACE_TASKS, "task slice", start, tasks[task.index].what, status != LUA_YIELD);
+
+    if (outermost) running_thread.store(nullptr, std::memory_order_release);
+    call_depth--;
+    callback_depth = depth;
+    current_slice = previous;
+
+    if (status == LUA_YIELD) {
+      lua_pop(thread, nres);
+      return yumsuccess;
+    }
+
+    done = true;
+
+    if (status != LUA_OK) {
+      std::string msg = lua_isstring(thread, -1) ? lua_tostring(thread, -1) : "(error object is not a string)";
+      msg += "* when resuming: `" + tasks[task.index].what + "`";
+
+      finish_task(task.index, true);
+
+      return syserr_t{
+        .category = failure_category(status),
+        .source   = { .func = lstring_from_string(__func__),
+                      .file = lstring_from_string(__FILE__),
+                      .line = __LINE__ },
+        .comment  = cxxstring2lstring(msg)
+      };
+    }
+
+    nargs = (uint64_t)nres;
+    if (nargs > 0) {
+      (*out) = (variant_t*)yumalloc(nargs * sizeof(variant_t));
+      int first = lua_gettop(thread) - nres + 1;
+      for (uint64_t i = 0; i < nargs; ++i) {
+        (*out)[i] = _static_units::variant_from_lua(thread, first + (int)i);
+      }
+    }
+
+    finish_task(task.index, false);
+    return yumsuccess;
+  }
+
+  void State::cancel(const taskhandle_t &task) {
+    busy_scope busy(this);
+    if (task.index >= tasks.size() || !tasks[task.index].active || tasks[task.index].generation != task.generation) return;
+
+    finish_task(task.index, true);
+  }
+
+  syserr_t State::execute(int top_before, utf8 what, uint64_t argc, const variant_t* args, call_record &record) {
+    // Push args AFTER function is already at stack top
+    _static_units::push_vararray_to_lua(L, argc, args);
+
+    // Call
+    YUM_DEBUG_PUTS("calling lua function")
+    record.executing();
+    int status = pcall((int)argc, LUA_MULTRET);
+    record.executed();
+
+    if (status != LUA_OK) {
+      record.finish(true);
+      std::string msg = lua_isstring(L, -1) ? lua_tostring(L, -1) : "(error object is not a string)";
+      msg += "* when calling: `" + std::string(what) + "`";
+
+      lua_settop(L, top_before);
+
+      return syserr_t{
+        .category = failure_category(status),
+        .source   = { .func = lstring_from_string(__func__),
+                      .file = lstring_from_string(__FILE__),
+                      .line = __LINE__ },
+        .comment  = cxxstring2lstring(msg)
+      };
+    }
+
+    return yumsuccess;
+  }
+
+  syserr_t State::invoke(int top_before, utf8 what, uint64_t argc, const variant_t* args, uint64_t& nargs, variant_t** out, call_record &record) {
+    syserr_t err = execute(top_before, what, argc, args, record);
+    if (err.category != err.OK) return err;
+
+    // Calculate returned values
+    int top_after = lua_gettop(L);
+    nargs = top_after - top_before;
+    YUM_DEBUG_PUTS("translating args")
+    if (nargs > 0) {
+      YUM_DEBUG_HERE
+      (*out) = (variant_t*)yumalloc(nargs * sizeof(variant_t));
+      YUM_DEBUG_HERE
+      int first_ret = top_after - nargs + 1;
+      YUM_DEBUG_HERE
+      for (uint64_t i = 0; i < nargs; ++i) {
+        (*out)[i] = _static_units::variant_from_lua(L, first_ret + i);
+      }
+    }
+
+    lua_settop(L, top_before);
+    record.finish(false);
+    YUM_DEBUG_OUTF
+    return err;
+  }
+
+  syserr_t State::invoke(int top_before, utf8 what, uint64_t argc, const variant_t* args, varframe_t &frame, call_record &record, yumlibc_framegrow_type grow, void *context) {
+    frame.count = 0;
+    frame.arena_used = 0;
+
+    syserr_t err = execute(top_before, what, argc, args, record);
+    if (err.category != err.OK) return err;
+
+    int top_after = lua_gettop(L);
+    bool fits = _static_units::frame_from_lua(L, top_before + 1, top_after - top_before, frame, true, nullptr, grow, context);
+
+    lua_settop(L, top_before);
+    record.finish(!fits);
+    YUM_DEBUG_OUTF
+    if (!fits) return yummakeerror_runtime("Returned values do not fit in the frame (see count and arena_used)", syserr_t::BUFFER_OVERFLOW);
+    return err;
+  }
+
+  void State::push_variant(utf8 name, const variant_t &var) {
+    busy_scope busy(this);
+    if (recorder) recorder->push(name, var);
+    _static_units::push_variant_to_lua(L, var);
     lua_setfield(L, -2, name);
     lua_pop(L, 1);
   }
 
   void State::new_table(utf8 name) {
+    busy_scope busy(this);
+    if (recorder) recorder->text(CallRecorder::NEW_TABLE, name);
     lua_newtable(L);
     lua_setfield(L, -2, name);
   }
 
   void State::push_table(utf8 name) {
+    busy_scope busy(this);
+    if (recorder) recorder->text(CallRecorder::TABLE, name);
     lua_getfield(L, -1, name);
   }
 
   void State::push_global(utf8 name) {
+    busy_scope busy(this);
+    if (recorder) recorder->text(CallRecorder::GLOBAL, name);
     lua_getglobal(L, name);
   }
 
+  int State::load_chunk(const char *source, size_t length, const char *chunkname) {
+    uint64_t start = Tracer::on(YUM_TRACE_LOADS) ? Tracer::now() : 0;
+
+    // Precompiled chunks gain nothing from the cache, which only compiles text.
+    bool precompiled = std::string_view(source, length).starts_with(LUA_SIGNATURE);
+    int status = chunk_cache && !precompiled
+               ? chunk_cache->load(L, source, length, chunkname) 
+               : _static_units::load_whole(L, source, length, chunkname);
+
+    if (start) Tracer::complete(YUM_TRACE_LOADS, "load", start, chunkname ? chunkname : "", length);
+    return status;
+  }
+
+  int State::load_file(utf8 path) {
+    MappedFile file;
+    if (!file.open(path, large_pages)) {
+      lua_pushfstring(L, "cannot open %s", path);
+      return LUA_ERRFILE;
+    }
+
+    std::string chunkname = std::string("@") + path;
+    std::string_view content(file.data(), file.size());
+
+    // Like luaL_loadfile: skip a UTF-8 BOM, then a first line starting with '#'.
+    if (content.starts_with("\xEF\xBB\xBF")) content.remove_prefix(3);
+    if (content.starts_with('#')) {
+      size_t newline = content.find('\n');
+      content.remove_prefix(newline == std::string_view::npos ? content.size() : newline);
+      // The newline stays for line numbers to match, unless a precompiled chunk follows.
+      if (content.starts_with("\n" LUA_SIGNATURE)) content.remove_prefix(1);
+    }
+
+    // Precompiled files gain nothing from the cache.
+    if (content.starts_with(LUA_SIGNATURE) || !chunk_cache) {
+      return _static_units::load_whole(L, content.data(), content.size(), chunkname.c_str());
+    }
+
+    return load_chunk(content.data(), content.size(), chunkname.c_str());
+  }
+
+  int State::archive_searcher(lua_State *L) {
+    State *state = *(State**)lua_getextraspace(L);
+    size_t length;
+    const char *name = luaL_checklstring(L, 1, &length);
+
+    for (const std::shared_ptr<Archive> &archive : state->archives) {
+      const Archive::entry *entry = archive->find(std::string_view(name, length));
+      if (!entry) continue;
+
+      const char *location = archive->location().c_str();
+      std::string_view chunk = archive->chunk(*entry);
+
+      lua_pushfstring(L, "@%s:%s", location, name);
+      if (_static_units::load_whole(L, chunk.data(), chunk.size(), lua_tostring(L, -1)) != LUA_OK) {
+        return luaL_error(L, "error loading module '%s' from archive '%s':\n\t%s", name, location, lua_tostring(L, -1));
+      }
+
+      lua_pushfstring(L, "%s:%s", location, name); // Second argument of the loader.
+      return 2;
+    }
+
+    int top = lua_gettop(L);
+    for (const std::shared_ptr<Archive> &archive : state->archives) {
+      if (lua_gettop(L) > top) lua_pushliteral(L, "\n\t");
+      lua_pushfstring(L, "no module '%s' in archive '%s'", name, archive->location().c_str());
+    }
+
+    lua_concat(L, lua_gettop(L) - top);
+    return 1;
+  }
+
+  syserr_t State::mount_archive(utf8 path) {
+    busy_scope busy(this);
+    if (!path) return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+
+    std::shared_ptr<Archive> archive = std::make_shared<Archive>();
+    std::string error;
+
+    if (!archive->open(path, error)) {
+      return syserr_t{
+        .category = syserr_t::FILE_NOT_FOUND,
+        .source   = { .func = lstring_from_string(__func__),
+                      .file = lstring_from_string(__FILE__),
+                      .line = __LINE__ },
+        .comment  = cxxstring2lstring(error)
+      };
+    }
+
+    int top = lua_gettop(L);
+    if (archives.empty()) {
+      lua_getglobal(L, "package");
+      if (!lua_istable(L, -1) || lua_getfield(L, -1, "searchers") != LUA_TTABLE) {
+        lua_settop(L, top);
+        return yummakeerror("package library is not opened", syserr_t::NOT_A_TABLE);
+      }
+
+      // Right after package.preload, before the filesystem searchers.
+      lua_Integer count = (lua_Integer)lua_rawlen(L, -1);
+      for (lua_Integer i = count; i >= 2; i--) {
+        lua_rawgeti(L, -1, i);
+        lua_rawseti(L, -2, i + 1);
+      }
+
+      lua_pushcfunction(L, archive_searcher);
+      lua_rawseti(L, -2, 2);
+    }
+
+    lua_settop(L, top);
+    archives.push_back(std::move(archive));
+    return yumsuccess;
+  }
+
+  void State::use_large_pages(boolean_t enabled) {
+    large_pages = enabled;
+  }
+
+  void State::use_bytecode_cache(utf8 directory) {
+    chunk_cache = directory ? std::make_shared<ChunkCache>(directory) : nullptr;
+  }
+
+  void State::use_bytecode_cache(std::shared_ptr<ChunkCache> cache) {
+    chunk_cache = std::move(cache);
+  }
+
   syserr_t State::run(utf8 source, boolean_t isfile) {
+    busy_scope busy(this);
     YUM_DEBUG_HERE
-    if (isfile) {
-      if (luaL_dofile(L, source) != LUA_OK)
-        return yummakeerror_runtime(lua_tostring(L, -1), syserr_t::LUA_EXECUTION_ERROR);
-    } else {
-      if (luaL_dostring(L, source) != LUA_OK)
-        return yummakeerror_runtime(lua_tostring(L, -1), syserr_t::LUA_EXECUTION_ERROR);
-    }
+    if (recorder) recorder->source(CallRecorder::RUN, source, isfile);
+    int status = isfile ? load_file(source) : load_chunk(source, strlen(source), source);
+    if (status != LUA_OK)
+      return yummakeerror_runtime(lua_tostring(L, -1), syserr_t::LUA_EXECUTION_ERROR);
+
+    status = pcall(0, LUA_MULTRET);
+    if (status != LUA_OK)
+      return yummakeerror_runtime(lua_tostring(L, -1), failure_category(status));
 
     YUM_DEBUG_OUTF
     return yumsuccess;
   }
 
   syserr_t State::load(const lstring_t &source, boolean_t isfile) {
+    busy_scope busy(this);
+    if (recorder) recorder->source(CallRecorder::LOAD, std::string_view(source.start, source.length), isfile);
     if (isfile) {
-      if (luaL_loadfile(L, source.start) != LUA_OK)
+      if (load_file(source.start) != LUA_OK)
         return yummakeerror_runtime(lua_tostring(L, -1), syserr_t::LUA_EXECUTION_ERROR);
     } else {
-      if (luaL_loadbuffer(L, source.start, source.length, "yumlibcxx_loadbuffer_api") != LUA_OK)
+      if (load_chunk(source.start, source.length, "yumlibcxx_loadbuffer_api") != LUA_OK)
         return yummakeerror_runtime(lua_tostring(L, -1), syserr_t::LUA_EXECUTION_ERROR);
     }
 
@@ -334,16 +2052,21 @@ namespace YumEngine::xV1 {
   }
 
   void State::ensure_path(utf8 path) {
+    busy_scope busy(this);
+    if (recorder) recorder->text(CallRecorder::ENSURE_PATH, path);
     _static_units::safe_walk(L, Sdk::strview(path, strlen(path)));
   }
 
   void State::clear() {
+    busy_scope busy(this);
+    if (recorder) recorder->text(CallRecorder::CLEAR, {});
     lua_settop(L, 0);
   }
 
   void State::open_stdlibs() {
+    busy_scope busy(this);
+    if (recorder) recorder->text(CallRecorder::OPEN_STDLIBS, {});
     luaL_openlibs(L);
+    stdlibs = true;
   }
 }
-
-// TODO: Lua.Debug utilities.
\ No newline at end of file
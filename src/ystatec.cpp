@@ -22,11 +22,18 @@
 
 #include "inc/types/variant.h"
 #include "inc/types/state.hpp"
+#include "inc/types/statetemplate.hpp"
 #include "inc/types/system/err.h"
 #include "inc/types/system/exception.hpp"
+#include "inc/utils/ystringutils.hpp"
 
 #include "inc/debug/dbgpoints.h"
 
+#include <new>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <typeinfo>
 
 using namespace YumEngine::xV1;
@@ -37,6 +44,50 @@ YumState *yumlibc_library_member(new)() {
   return new YumState();
 }
 
+YumState *yumlibc_library_member(new_with)(const allocpolicy_t *policy) {
+  if (!policy) return new YumState();
+
+  try {
+    return new YumState(*policy);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+/* The C handle owns a reference to the shared template. */
+struct YumStateTemplateHandle {
+  std::shared_ptr<const YumStateTemplate> source;
+};
+
+YumState *yumlibc_library_member(new_from)(const YumStateTemplate *source, const allocpolicy_t *policy) {
+  if (!source) return nullptr;
+  const YumStateTemplateHandle *handle = (const YumStateTemplateHandle*)source;
+
+  try {
+    return policy ? new YumState(*handle->source, *policy) : new YumState(*handle->source);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+YumStateTemplate *yumlibc_library_member(capture)(YumState *state) {
+  if (!state) return nullptr;
+
+  try {
+    return (YumStateTemplate*)new YumStateTemplateHandle{ state->capture() };
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void yumlibc_library_member(delete_template)(const YumStateTemplate *source) {
+  if (source) delete (const YumStateTemplateHandle*)source;
+}
+
+boolean_t yumlibc_library_member(rebind_callback)(YumState *state, uint64_t id, void *context) {
+  return state ? state->rebind_callback(id, context) : false;
+}
+
 void yumlibc_library_member(delete)(const YumState *state) {
   if (state) delete state;
 }
@@ -58,6 +109,38 @@ syserr_t yumlibc_library_member(push_callback)(YumState *state, utf8 name, const
   return yumsuccess;
 }
 
+syserr_t yumlibc_library_member(push_ctxcallback)(YumState *state, utf8 name, const yum_ctxcallback callback, void *context, uint64_t *id) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  try {
+    uint64_t pushed = state->push_callback(name, callback, context);
+    if (id) *id = pushed;
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+syserr_t yumlibc_library_member(push_fastcallback)(YumState *state, utf8 name, const yum_fastcallback callback, void *context, uint64_t *id) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  try {
+    uint64_t pushed = state->push_callback(name, callback, context);
+    if (id) *id = pushed;
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+void yumlibc_library_member(remove_callback)(YumState *state, uint64_t id) {
+  if (state) state->remove_callback(id);
+}
+
 syserr_t yumlibc_library_member(call)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, uint64_t *outc, variant_t **out) {
   if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
   if (!path) {
@@ -75,6 +158,217 @@ syserr_t yumlibc_library_member(call)(YumState *state, utf8 path, uint64_t argc,
   return yumsuccess;
 }
 
+syserr_t yumlibc_library_member(call_into)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, varframe_t *frame) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!frame) {
+    return yummakeerror("(varframe_t*)frame is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call(path, strlen(path), argc, argv, *frame);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+syserr_t yumlibc_library_member(call_borrowed)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, varframe_t *frame, callscope_t *scope) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!frame || !scope) {
+    return yummakeerror("(varframe_t*)frame or (callscope_t*)scope is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call(path, strlen(path), argc, argv, *frame, *scope);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+void yumlibc_library_member(release_scope)(YumState *state, callscope_t *scope) {
+  if (state && scope) state->release(*scope);
+}
+
+syserr_t yumlibc_library_member(call_visit)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, yumlibc_visitor_type visitor, void *context) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!visitor) {
+    return yummakeerror("(yumlibc_visitor_type)visitor is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call(path, strlen(path), argc, argv, visitor, context);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+syserr_t yumlibc_library_member(resolve)(YumState *state, utf8 path, fnhandle_t *handle) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!handle) {
+    return yummakeerror("(fnhandle_t*)handle is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->resolve(path, strlen(path), *handle);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+syserr_t yumlibc_library_member(call_handle)(YumState *state, const fnhandle_t *handle, uint64_t argc, const variant_t *argv, uint64_t *outc, variant_t **out) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!handle) {
+    return yummakeerror("(fnhandle_t*)handle is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call(*handle, argc, argv, *outc, out);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+syserr_t yumlibc_library_member(call_handle_into)(YumState *state, const fnhandle_t *handle, uint64_t argc, const variant_t *argv, varframe_t *frame) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!handle) {
+    return yummakeerror("(fnhandle_t*)handle is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!frame) {
+    return yummakeerror("(varframe_t*)frame is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call(*handle, argc, argv, *frame);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+syserr_t yumlibc_library_member(call_batch)(YumState *state, utf8 path, uint64_t count, uint64_t argc, const variant_t *argv, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t *nfailed) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!nfailed || (count * outc > 0 && !out)) {
+    return yummakeerror("(uint64_t*)nfailed or (variant_t*)out is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call_batch(path, strlen(path), count, argc, argv, outc, out, errors, *nfailed);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+syserr_t yumlibc_library_member(call_batch_handle)(YumState *state, const fnhandle_t *handle, uint64_t count, uint64_t argc, const variant_t *argv, uint64_t outc, variant_t *out, syserr_t *errors, uint64_t *nfailed) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!handle) {
+    return yummakeerror("(fnhandle_t*)handle is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!nfailed || (count * outc > 0 && !out)) {
+    return yummakeerror("(uint64_t*)nfailed or (variant_t*)out is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call_batch(*handle, count, argc, argv, outc, out, errors, *nfailed);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+void yumlibc_library_member(release_handle)(YumState *state, fnhandle_t *handle) {
+  if (state && handle) state->release(*handle);
+}
+
+syserr_t yumlibc_library_member(call_async)(YumState *state, utf8 path, uint64_t argc, const variant_t *argv, const timeslice_t *slice, taskhandle_t *task, boolean_t *done, uint64_t *outc, variant_t **out) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!slice || !task || !done) {
+    return yummakeerror("(timeslice_t*)slice, (taskhandle_t*)task or (boolean_t*)done is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call_async(path, strlen(path), argc, argv, *slice, *task, *done, *outc, out);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+}
+
+syserr_t yumlibc_library_member(call_handle_async)(YumState *state, const fnhandle_t *handle, uint64_t argc, const variant_t *argv, const timeslice_t *slice, taskhandle_t *task, boolean_t *done, uint64_t *outc, variant_t **out) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!handle) {
+    return yummakeerror("(fnhandle_t*)handle is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!slice || !task || !done) {
+    return yummakeerror("(timeslice_t*)slice, (taskhandle_t*)task or (boolean_t*)done is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->call_async(*handle, argc, argv, *slice, *task, *done, *outc, out);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+}
+
+syserr_t yumlibc_library_member(resume)(YumState *state, const taskhandle_t *task, const timeslice_t *slice, boolean_t *done, uint64_t *outc, variant_t **out) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!task || !slice || !done) {
+    return yummakeerror("(taskhandle_t*)task, (timeslice_t*)slice or (boolean_t*)done is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    return state->resume(*task, *slice, *done, *outc, out);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+}
+
+void yumlibc_library_member(cancel)(YumState *state, const taskhandle_t *task) {
+  if (state && task) state->cancel(*task);
+}
+
 syserr_t yumlibc_library_member(push_variant)(YumState *state, utf8 name, const variant_t *var) {
   if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
   if (!name) {
@@ -185,4 +479,202 @@ void yumlibc_library_member(clear)(YumState *state) {
   }
 }
 
+void yumlibc_library_member(memory_stats)(const YumState *state, memstats_t *stats) {
+  if (state && stats) {
+    *stats = state->memory_stats();
+  }
+}
+
+boolean_t yumlibc_library_member(set_memory_limit)(YumState *state, uint64_t limit) {
+  return state ? state->set_memory_limit(limit) : false;
+}
+
+void yumlibc_library_member(use_bytecode_cache)(YumState *state, utf8 directory) {
+  if (state) {
+    state->use_bytecode_cache(directory);
+  }
+}
+
+void yumlibc_library_member(use_large_pages)(YumState *state, boolean_t enabled) {
+  if (state) {
+    state->use_large_pages(enabled);
+  }
+}
+
+syserr_t yumlibc_library_member(mount_archive)(YumState *state, utf8 path) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  return state->mount_archive(path);
+}
+
+syserr_t yumlibc_library_member(write_archive)(utf8 path, uint64_t count, const utf8 *names, const lstring_t *sources, boolean_t precompile) {
+  if (!path || (count && (!names || !sources))) return yummakeerror("(utf8)path, names or sources is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+
+  syserr_t err;
+  try {
+    std::vector<Archive::source> modules(count);
+    for (uint64_t i = 0; i < count; i++) {
+      modules[i].name  = names[i];
+      modules[i].chunk = std::string(sources[i].start, sources[i].length);
+    }
+
+    std::string error;
+    if (Archive::write(path, modules, precompile, error)) {
+      err = yumsuccess;
+    } else {
+      err = syserr_t{
+        .category = syserr_t::ERROR,
+        .source   = { .func = lstring_from_string(__func__),
+                      .file = lstring_from_string(__FILE__),
+                      .line = __LINE__ },
+        .comment  = cxxstring2lstring(error)
+      };
+    }
+  } catch (const std::exception &e) {
+    err = yumlibcxx_promote_this_exception(e);
+  }
+
+  return err;
+}
+
+void yumlibc_library_member(gc_mode)(YumState *state, gcmode_t mode) {
+  if (state) state->gc_mode(mode);
+}
+
+boolean_t yumlibc_library_member(gc_step)(YumState *state, uint64_t budget_us) {
+  return state ? state->gc_step(budget_us) : false;
+}
+
+void yumlibc_library_member(gc_collect)(YumState *state) {
+  if (state) state->gc_collect();
+}
+
+void yumlibc_library_member(gc_stop)(YumState *state) {
+  if (state) state->gc_stop();
+}
+
+void yumlibc_library_member(gc_restart)(YumState *state) {
+  if (state) state->gc_restart();
+}
+
+boolean_t yumlibc_library_member(gc_running)(const YumState *state) {
+  return state ? state->gc_running() : false;
+}
+
+void yumlibc_library_member(gc_stats)(const YumState *state, gcstats_t *stats) {
+  if (state && stats) *stats = state->gc_stats();
+}
+
+void yumlibc_library_member(gc_reset_stats)(YumState *state) {
+  if (state) state->gc_reset_stats();
+}
+
+void yumlibc_library_member(set_call_budget)(YumState *state, const callbudget_t *budget) {
+  if (state) state->set_call_budget(budget ? *budget : callbudget_t{});
+}
+
+void yumlibc_library_member(interrupt)(YumState *state) {
+  if (state) state->interrupt();
+}
+
+void yumlibc_library_member(start_profiler)(YumState *state, profmode_t mode, uint64_t period) {
+  if (state) state->start_profiler(mode, period);
+}
+
+void yumlibc_library_member(stop_profiler)(YumState *state) {
+  if (state) state->stop_profiler();
+}
+
+void yumlibc_library_member(reset_profile)(YumState *state) {
+  if (state) state->reset_profile();
+}
+
+/* The returned lstring owns its characters: free them with yumfree(). */
+lstring_t yumlibc_library_member(profile_folded)(const YumState *state) {
+  if (!state) return lstring_t{ .start = nullptr, .length = 0, .owns = false };
+  return cxxstring2lstring(state->profile().folded());
+}
+
+/* Fills up to `n` entries, whose frames are owned (free them with yumfree()). Returns the count filled. */
+uint64_t yumlibc_library_member(profile_top)(const YumState *state, uint64_t n, profentry_t *entries) {
+  if (!state || !entries) return 0;
+
+  std::vector<Profiler::entry> top = state->profile().top(n);
+  for (uint64_t i = 0; i < top.size(); i++) {
+    entries[i] = profentry_t{ .frame = cxxstring2lstring(top[i].frame), .self = top[i].self, .total = top[i].total };
+  }
+
+  return top.size();
+}
+
+/* Enabling keeps the stats already used, if any. Disabling forgets them. */
+void yumlibc_library_member(enable_call_stats)(YumState *state, boolean_t enable) {
+  if (!state) return;
+  if (!enable) state->use_call_stats(nullptr);
+  else if (!state->call_stats()) state->use_call_stats(std::make_shared<CallStats>());
+}
+
+/* Records the calls of `state` with those of `source`, e.g. across the States of a pool. */
+void yumlibc_library_member(share_call_stats)(YumState *state, const YumState *source) {
+  if (state && source) state->use_call_stats(source->call_stats());
+}
+
+/*
+ * Fills up to `capacity` entries, whose names are owned (free them with yumfree()).
+ * Returns the count of names recorded, which may exceed `capacity`.
+ */
+uint64_t yumlibc_library_member(call_stats)(const YumState *state, uint64_t capacity, callstat_t *entries) {
+  if (!state || !state->call_stats()) return 0;
+
+  std::vector<CallStats::entry> stats = state->call_stats()->snapshot();
+  for (uint64_t i = 0; entries && i < std::min<uint64_t>(capacity, stats.size()); i++) {
+    const CallStats::entry &e = stats[i];
+    entries[i] = callstat_t{ 
+      .name = cxxstring2lstring(e.name), .callback = e.kind == CallStats::HOST_CALLBACK,
+      .calls = e.calls, .errors = e.errors, .marshal_ns = e.marshal_ns, .exec_ns = e.exec_ns,
+      .p50_ns = e.percentile(0.5), .p90_ns = e.percentile(0.9), .p99_ns = e.percentile(0.99), .p999_ns = e.percentile(0.999),
+      .max_ns = e.max_ns, .counted = e.counted,
+      .cycles = e.hardware[PerfCounters::CYCLES], .instructions = e.hardware[PerfCounters::INSTRUCTIONS],
+      .l1d_misses = e.hardware[PerfCounters::L1D_MISSES], .llc_misses = e.hardware[PerfCounters::LLC_MISSES],
+      .branch_misses = e.hardware[PerfCounters::BRANCH_MISSES]
+    };
+  }
+
+  return stats.size();
+}
+
+/*
+ * Has the call stats of `state` read hardware counters around calls and callbacks (Linux, perf_event_open).
+ * Needs enable_call_stats first. Returns whether the calling thread can count; other threads open their own.
+ */
+boolean_t yumlibc_library_member(enable_hardware_counters)(YumState *state, boolean_t enable) {
+  if (!state || !state->call_stats()) return false;
+
+  state->call_stats()->count_hardware(enable);
+  return enable && PerfCounters::available();
+}
+
+/* Logs the calls of `state` to the file at `path`, for replay. A null `path` stops logging. */
+syserr_t yumlibc_library_member(record_calls)(YumState *state, utf8 path) {
+  if (!state) return yummakeerror("(YumState*)state pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    state->record_calls(nullptr);
+    return yumsuccess;
+  }
+
+  try {
+    std::string error;
+    std::shared_ptr<CallRecorder> recorder = std::make_shared<CallRecorder>();
+    if (!recorder->open(path, error)) return yummakeerror_runtime("Could not open the call log", syserr_t::FILE_NOT_FOUND);
+    state->record_calls(std::move(recorder));
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+void yumlibc_library_member(flush_call_log)(YumState *state) {
+  if (state && state->call_recorder()) state->call_recorder()->flush();
+}
+
 yumlibcxx_c_header_decoration_end
\ No newline at end of file
@@ -0,0 +1,158 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/lua/lua.hpp"
+#include "inc/types/state.hpp"
+#include "inc/debug/tracer.hpp"
+
+#include <bit>
+#include <chrono>
+#include <algorithm>
+
+namespace YumEngine::xV1 {
+  namespace {
+    using gc_clock = std::chrono::steady_clock;
+
+    inline uint64_t elapsed_ns(gc_clock::time_point since) {
+      return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(gc_clock::now() - since).count();
+    }
+
+    inline uint64_t pause_bucket(uint64_t ns) {
+      uint64_t us = ns / 1000;
+      return std::min<uint64_t>(std::bit_width(us), YUM_GC_PAUSE_BUCKETS - 1);
+    }
+  }
+
+  uint64_t State::heap_bytes() const {
+    return (uint64_t)lua_gc(L, LUA_GCCOUNT) * 1024 + (uint64_t)lua_gc(L, LUA_GCCOUNTB);
+  }
+
+  void State::gc_account(const char *what, uint64_t ns, uint64_t freed) {
+    if (Tracer::on(YUM_TRACE_GC)) {
+      uint64_t now = Tracer::now();
+      Tracer::complete(YUM_TRACE_GC, what, now - std::min(ns, now), {}, freed);
+      Tracer::counter(YUM_TRACE_GC, "lua heap", heap_bytes());
+    }
+
+    gc_counters.collected_bytes += freed;
+    gc_counters.total_ns += ns;
+    gc_counters.max_ns = std::max(gc_counters.max_ns, ns);
+    gc_counters.pauses[pause_bucket(ns)]++;
+  }
+
+  void State::gc_mode(gcmode_t mode) {
+    busy_scope busy(this);
+    if (mode == YUM_GC_GENERATIONAL) lua_gc(L, LUA_GCGEN, 0, 0);
+    else lua_gc(L, LUA_GCINC, 0, 0, 0);
+    gc_generational = mode == YUM_GC_GENERATIONAL;
+  }
+
+  bool State::gc_step(uint64_t budget_us) {
+    busy_scope busy(this);
+    uint64_t before = heap_bytes();
+    uint64_t budget_ns = budget_us * 1000;
+    gc_clock::time_point start = gc_clock::now();
+
+    // Basic steps are small, so the budget is overshot by at most one of them.
+    // A generational step is a young collection: Lua never reports it as the end of a cycle.
+    bool completed = false;
+    uint64_t ns = 0;
+    do {
+      completed = lua_gc(L, LUA_GCSTEP, 0) != 0 || gc_generational;
+      ns = elapsed_ns(start);
+    } while (!completed && ns < budget_ns);
+
+    uint64_t after = heap_bytes();
+
+    gc_counters.steps++;
+    if (completed) gc_counters.cycles++;
+    gc_account("gc step", ns, before > after ? before - after : 0);
+    return completed;
+  }
+
+  void State::gc_collect() {
+    busy_scope busy(this);
+    uint64_t before = heap_bytes();
+    gc_clock::time_point start = gc_clock::now();
+
+    lua_gc(L, LUA_GCCOLLECT);
+
+    uint64_t ns = elapsed_ns(start);
+    uint64_t after = heap_bytes();
+
+    gc_counters.collections++;
+    gc_account("gc collect", ns, before > after ? before - after : 0);
+  }
+
+  bool State::gc_background(uint64_t budget_us, uint64_t threshold) {
+    uint64_t before = heap_bytes();
+    gc_baseline = std::min(gc_baseline, before); // The host collected meanwhile.
+    if (before < gc_baseline + threshold) return false;
+
+    uint64_t budget_ns = budget_us * 1000;
+    gc_clock::time_point start = gc_clock::now();
+
+    // Finalizers calling back into the State must not wait for the handoff this thread holds.
+    // A generational step is a young collection, after which the heap is as small as it gets until the next one.
+    collecting = this;
+    bool completed = false;
+    uint64_t ns = 0;
+    do {
+      completed = lua_gc(L, LUA_GCSTEP, 0) != 0 || gc_generational;
+      ns = elapsed_ns(start);
+    } while (!completed && ns < budget_ns && !gc_handoff_requested.load(std::memory_order_relaxed));
+    collecting = nullptr;
+
+    uint64_t after = heap_bytes();
+    if (completed) gc_baseline = after;
+
+    gc_counters.steps++;
+    if (completed) gc_counters.cycles++;
+    gc_account("gc background step", ns, before > after ? before - after : 0);
+    return true;
+  }
+
+  void State::gc_stop() {
+    busy_scope busy(this);
+    lua_gc(L, LUA_GCSTOP);
+  }
+
+  void State::gc_restart() {
+    busy_scope busy(this);
+    lua_gc(L, LUA_GCRESTART);
+  }
+
+  bool State::gc_running() const {
+    busy_scope busy(this);
+    return lua_gc(L, LUA_GCISRUNNING) != 0;
+  }
+
+  gcstats_t State::gc_stats() const {
+    busy_scope busy(this);
+    return gc_counters;
+  }
+
+  void State::gc_reset_stats() {
+    busy_scope busy(this);
+    gc_counters = {};
+  }
+}
@@ -0,0 +1,261 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/statepool.hpp"
+#include "inc/types/state.hpp"
+#include "inc/types/variant.h"
+#include "inc/types/system/err.h"
+#include "inc/types/system/exception.hpp"
+#include "inc/utils/ystringutils.hpp"
+
+#include "inc/debug/dbgpoints.h"
+
+#include <algorithm>
+#include <cstring>
+#include <latch>
+
+namespace YumEngine::xV1 {
+  namespace {
+    constexpr uint32_t max_idle_spins = 64;
+  }
+
+  StatePool::StatePool(uint64_t nthreads, pool_initializer initializer, void *context) {
+    if (nthreads == 0) nthreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (uint64_t i = 0; i < nthreads; i++) workers.push_back(std::make_unique<worker>());
+
+    // States are created and initialized on their own worker, the pool is usable once they all are.
+    std::latch ready((std::ptrdiff_t)nthreads);
+    for (uint64_t i = 0; i < nthreads; i++) {
+      workers[i]->thread = std::thread(&StatePool::run, this, i, initializer, context, std::ref(ready));
+    }
+    ready.wait();
+
+    // A State that failed to initialize would fail its jobs obscurely: the pool is not built at all.
+    for (auto &w : workers) {
+      if (w->failure) {
+        std::exception_ptr failure = w->failure;
+        stop();
+        std::rethrow_exception(failure);
+      }
+    }
+  }
+
+  StatePool::~StatePool() {
+    stop();
+  }
+
+  void StatePool::stop() {
+    stopping.store(true);
+    for (auto &w : workers) {
+      std::lock_guard<std::mutex> guard(w->lock);
+      w->wake.notify_one();
+    }
+
+    for (auto &w : workers) {
+      if (w->thread.joinable()) w->thread.join();
+    }
+  }
+
+  std::unique_ptr<StatePool::job> StatePool::make_job(utf8 path, uint64_t argc, const variant_t *args) {
+    auto task = std::make_unique<job>();
+    task->path = path;
+    task->args.assign(args, args + argc);
+
+    uint64_t bytes = 0;
+    for (const variant_t &arg : task->args) {
+      if (arg.type == variant_t::VARIANT_STRING) bytes += arg.hold.lstring.length;
+      else if (arg.type == variant_t::VARIANT_BINARY) bytes += arg.hold.binary.length;
+    }
+
+    // The caller may free its strings once submitted: the job keeps its own copies.
+    task->bytes.resize(bytes);
+    char *cursor = task->bytes.data();
+    for (variant_t &arg : task->args) {
+      if (arg.type == variant_t::VARIANT_STRING && arg.hold.lstring.length > 0) {
+        std::memcpy(cursor, arg.hold.lstring.start, arg.hold.lstring.length);
+        arg.hold.lstring = lstring_t{ .start = cursor, .length = arg.hold.lstring.length, .owns = yumfalse };
+        cursor += arg.hold.lstring.length;
+      } else if (arg.type == variant_t::VARIANT_BINARY && arg.hold.binary.length > 0) {
+        std::memcpy(cursor, arg.hold.binary.start, arg.hold.binary.length);
+        arg.hold.binary = binary_t{ .start = (const uint8_t*)cursor, .length = arg.hold.binary.length, .owns = yumfalse };
+        cursor += arg.hold.binary.length;
+      }
+    }
+
+    return task;
+  }
+
+  void StatePool::enqueue(std::unique_ptr<job> task, uint64_t affinity) {
+    if (affinity != no_affinity) {
+      // Only its worker may run a pinned job: no one else is woken for it.
+      worker &w = *workers[affinity % workers.size()];
+      std::lock_guard<std::mutex> guard(w.lock);
+      w.pinned.push_back(std::move(task));
+      if (w.asleep) w.wake.notify_one();
+      return;
+    }
+
+    // Counted before it is queued, so that taking it never sees the count below zero.
+    // Paired with run(): a worker counts itself asleep before it looks at `stealable` a last time.
+    stealable.fetch_add(1);
+
+    uint64_t target = next.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    {
+      worker &w = *workers[target];
+      std::lock_guard<std::mutex> guard(w.lock);
+      w.jobs.push_back(std::move(task));
+    }
+
+    if (sleepers.load() > 0) wake_one(target);
+  }
+
+  void StatePool::wake_one(uint64_t first) {
+    for (uint64_t i = 0; i < workers.size(); i++) {
+      worker &w = *workers[(first + i) % workers.size()];
+      std::lock_guard<std::mutex> guard(w.lock);
+      if (w.asleep) {
+        w.wake.notify_one();
+        return;
+      }
+    }
+  }
+
+  std::unique_ptr<StatePool::job> StatePool::take(uint64_t self) {
+    worker &own = *workers[self];
+    {
+      std::lock_guard<std::mutex> guard(own.lock);
+      if (!own.pinned.empty()) {
+        auto task = std::move(own.pinned.front());
+        own.pinned.pop_front();
+        return task;
+      }
+
+      if (!own.jobs.empty()) {
+        auto task = std::move(own.jobs.back());
+        own.jobs.pop_back();
+        stealable.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+
+    for (uint64_t i = 1; i < workers.size(); i++) {
+      worker &victim = *workers[(self + i) % workers.size()];
+      std::unique_lock<std::mutex> guard(victim.lock, std::try_to_lock);
+      if (!guard.owns_lock() || victim.jobs.empty()) continue;
+
+      auto task = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      stealable.fetch_sub(1, std::memory_order_relaxed);
+      return task;
+    }
+
+    return nullptr;
+  }
+
+  void StatePool::run(uint64_t self, pool_initializer initializer, void *context, std::latch &ready) {
+    worker &own = *workers[self];
+    own.state = std::make_unique<State>();
+
+    try {
+      if (initializer) initializer(*own.state, context);
+    } catch (...) {
+      own.failure = std::current_exception();
+    }
+    ready.count_down();
+
+    uint32_t idle_spins = 0;
+    for (;;) {
+      std::unique_ptr<job> task = take(self);
+
+      if (task) {
+        idle_spins = 0;
+        execute(*own.state, *task);
+        continue;
+      }
+
+      // Bursts of short jobs: look again a few times before paying for a sleep and a wake-up.
+      if (idle_spins++ < max_idle_spins) {
+        std::this_thread::yield();
+        continue;
+      }
+      idle_spins = 0;
+
+      std::unique_lock<std::mutex> guard(own.lock);
+      if (!own.pinned.empty()) continue;
+
+      // Counted asleep before the last look at `stealable`, so that enqueue() either sees a sleeper or is seen.
+      own.asleep = true;
+      sleepers.fetch_add(1);
+      bool idle = own.jobs.empty() && stealable.load() == 0;
+      if (idle && stopping.load()) {
+        own.asleep = false;
+        sleepers.fetch_sub(1);
+        break;
+      }
+
+      if (idle) own.wake.wait(guard);
+      own.asleep = false;
+      sleepers.fetch_sub(1);
+    }
+
+    own.state.reset();
+  }
+
+  void StatePool::execute(State &state, job &task) {
+    PoolResult result;
+
+    try {
+      result.err = state.call(task.path.c_str(), task.path.size(), task.args.size(), task.args.data(), result.count, &result.values);
+    } catch (const sysexception &e) {
+      result.err = e.geterr();
+    } catch (const std::exception &e) {
+      result.err = yumlibcxx_promote_this_exception(e);
+    }
+
+    if (result.err.category != result.err.OK) state.clear();
+
+    if (task.completion) {
+      uint64_t count = result.count;
+      variant_t *values = result.values;
+      result.count = 0;
+      result.values = nullptr;
+      task.completion(task.context, result.err, count, values);
+    } else {
+      task.promise.set_value(std::move(result));
+    }
+  }
+
+  std::future<PoolResult> StatePool::submit(utf8 path, uint64_t argc, const variant_t *args, uint64_t affinity) {
+    auto task = make_job(path, argc, args);
+    std::future<PoolResult> future = task->promise.get_future();
+    enqueue(std::move(task), affinity);
+    return future;
+  }
+
+  void StatePool::submit(utf8 path, uint64_t argc, const variant_t *args, uint64_t affinity, pool_completion completion, void *context) {
+    auto task = make_job(path, argc, args);
+    task->completion = completion;
+    task->context = context;
+    enqueue(std::move(task), affinity);
+  }
+}
@@ -0,0 +1,86 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/types/statepool.hpp"
+#include "inc/types/system/err.h"
+#include "inc/types/system/exception.hpp"
+
+#include <typeinfo>
+
+using namespace YumEngine::xV1;
+
+/* Same as inc/api/ystatepoolc.h, seen from C++ (YumState and YumStatePool are the C++ classes here). */
+typedef void (*yumlibc_pool_initializer_type)(YumState *state, void *context);
+typedef pool_completion yumlibc_pool_completion_type;
+
+namespace {
+  struct c_initializer {
+    yumlibc_pool_initializer_type initializer;
+    void                         *context;
+  };
+
+  void initialize_from_c(State &state, void *context) {
+    c_initializer *init = (c_initializer*)context;
+    init->initializer(&state, init->context);
+  }
+}
+
+yumlibcxx_c_header_decoration_begin
+
+YumStatePool *yumlibc_library_member(pool_new)(uint64_t nthreads, yumlibc_pool_initializer_type initializer, void *context) {
+  // The pool initializes every State before returning: the initializer can live on this stack.
+  c_initializer init { .initializer = initializer, .context = context };
+  try {
+    return new YumStatePool(nthreads, initializer ? initialize_from_c : nullptr, &init);
+  } catch (...) {
+    return nullptr; // Initializers may throw anything, and it must not cross into C.
+  }
+}
+
+void yumlibc_library_member(pool_delete)(YumStatePool *pool) {
+  if (pool) delete pool;
+}
+
+uint64_t yumlibc_library_member(pool_size)(const YumStatePool *pool) {
+  return pool ? pool->size() : 0;
+}
+
+syserr_t yumlibc_library_member(pool_submit)(YumStatePool *pool, utf8 path, uint64_t argc, const variant_t *argv, uint64_t affinity, yumlibc_pool_completion_type completion, void *context) {
+  if (!pool) return yummakeerror("(YumStatePool*)pool pointer is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  if (!path) {
+    return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  } else if (!completion) {
+    return yummakeerror("(yumlibc_pool_completion_type)completion is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+  }
+
+  try {
+    pool->submit(path, argc, argv, affinity, completion, context);
+  } catch (const sysexception &e) {
+    return e.geterr();
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+yumlibcxx_c_header_decoration_end
@@ -0,0 +1,509 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/lua/lua.hpp"
+#include "inc/types/statetemplate.hpp"
+#include "inc/types/system/err.h"
+#include "inc/types/system/exception.hpp"
+#include "inc/debug/dbgpoints.h"
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+/*
+ * Image format. Every value starts with a tag byte:
+ *   NIL, FALSE, TRUE
+ *   INTEGER <8 bytes>, NUMBER <8 bytes>, STRING <varint length> <bytes>, LIGHTUSERDATA <8 bytes>
+ *   REF <varint id>                         a table or function met before
+ *   TABLE (<key> <value>)* END <metatable>  a new table
+ *   KNOWN <name> (<key> <value>)* END <metatable>
+ *                                           a table the restored State already has (_G, a standard library, ...),
+ *                                           filled in place
+ *   LUA_FUNCTION <varint prototype> <varint count> <upvalue>*
+ *   C_FUNCTION <8 bytes> <varint count> <upvalue>*
+ * An upvalue is a value, or JOIN <varint id> <varint index> when it is shared with a function met before.
+ * Tables and functions get ids in the order they first appear. The image holds the globals, then the loaded
+ * modules table (NIL when the State has none). A KNOWN table missing from the restored State is created anew.
+ */
+
+namespace YumEngine::xV1 {
+  namespace {
+    enum tag : uint8_t {
+      NIL, FALSE, TRUE, INTEGER, NUMBER, STRING, LIGHTUSERDATA, REF, TABLE, KNOWN, END, LUA_FUNCTION, C_FUNCTION, JOIN
+    };
+
+    constexpr const char *known_tables[] = {
+      "_G", "package", "coroutine", "table", "io", "os", "string", "math", "utf8", "debug"
+    };
+
+    inline bool capturable(int type) {
+      return type != LUA_TUSERDATA && type != LUA_TTHREAD;
+    }
+
+    int dump_writer(lua_State *, const void *p, size_t sz, void *ud) {
+      ((std::string*)ud)->append((const char*)p, sz);
+      return 0;
+    }
+
+    /** 
+     * @brief Pushes a known table of `L`. Pushes nothing and returns false when it is missing: creating it would
+     * change the State, e.g. `require` would find an empty standard library.
+     */
+    bool push_known(lua_State *L, const char *name) {
+      if (strcmp(name, "_G") == 0) {
+        lua_pushglobaltable(L);
+        return true;
+      }
+
+      bool registered = strcmp(name, LUA_LOADED_TABLE) == 0 || strcmp(name, LUA_PRELOAD_TABLE) == 0;
+      if (registered) {
+        lua_pushstring(L, name);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+      } else {
+        lua_pushliteral(L, LUA_LOADED_TABLE);
+        if (lua_rawget(L, LUA_REGISTRYINDEX) == LUA_TTABLE) {
+          lua_pushstring(L, name);
+          lua_rawget(L, -2);
+        } else {
+          lua_pushnil(L);
+        }
+        lua_remove(L, -2);
+      }
+
+      if (lua_istable(L, -1)) return true;
+      lua_pop(L, 1);
+      return false;
+    }
+
+    struct image_writer {
+      lua_State                *L;
+      std::string              &out;
+      std::vector<std::string> &prototypes;
+
+      std::unordered_map<const void*, uint64_t>                      ids = {};
+      std::unordered_map<const void*, const char*>                   known = {};
+      std::unordered_map<void*, std::pair<uint64_t, int>>            upvalues = {};
+      std::unordered_map<std::string, uint64_t>                      prototype_ids = {};
+      uint64_t                                                       next_id = 0;
+
+      void byte(uint8_t b) { out.push_back((char)b); }
+      void raw(const void *data, size_t size) { out.append((const char*)data, size); }
+
+      void varint(uint64_t v) {
+        while (v >= 0x80) {
+          byte((uint8_t)(v | 0x80));
+          v >>= 7;
+        }
+        byte((uint8_t)v);
+      }
+
+      void string(const char *s, size_t length) {
+        varint(length);
+        raw(s, length);
+      }
+
+      void learn_known() {
+        for (const char *name : known_tables) {
+          if (!push_known(L, name)) continue;
+          known.emplace(lua_topointer(L, -1), name);
+          lua_pop(L, 1);
+        }
+
+        for (const char *name : { LUA_LOADED_TABLE, LUA_PRELOAD_TABLE }) {
+          if (!push_known(L, name)) continue;
+          known.emplace(lua_topointer(L, -1), name);
+          lua_pop(L, 1);
+        }
+      }
+
+      void upvalue(int function, uint64_t id, int n, bool shareable) {
+        if (shareable) {
+          void *uid = lua_upvalueid(L, function, n);
+          auto it = upvalues.find(uid);
+          if (it != upvalues.end()) {
+            byte(JOIN);
+            varint(it->second.first);
+            varint((uint64_t)it->second.second);
+            return;
+          }
+          upvalues.emplace(uid, std::make_pair(id, n));
+        }
+
+        lua_getupvalue(L, function, n);
+        if (capturable(lua_type(L, -1))) value(-1);
+        else byte(NIL);
+        lua_pop(L, 1);
+      }
+
+      void function(int idx, uint64_t id) {
+        int count = 0;
+        while (lua_getupvalue(L, idx, count + 1)) {
+          lua_pop(L, 1);
+          count++;
+        }
+
+        bool is_c = lua_iscfunction(L, idx);
+        if (is_c) {
+          uint64_t pointer = (uint64_t)(uintptr_t)lua_tocfunction(L, idx);
+          byte(C_FUNCTION);
+          raw(&pointer, sizeof(pointer));
+        } else {
+          std::string code;
+          lua_pushvalue(L, idx);
+          lua_dump(L, dump_writer, &code, 0);
+          lua_pop(L, 1);
+
+          auto [it, inserted] = prototype_ids.emplace(std::move(code), prototypes.size());
+          if (inserted) prototypes.push_back(it->first);
+
+          byte(LUA_FUNCTION);
+          varint(it->second);
+        }
+
+        varint((uint64_t)count);
+        for (int n = 1; n <= count; n++) upvalue(idx, id, n, !is_c);
+      }
+
+      void table(int idx) {
+        auto it = known.find(lua_topointer(L, idx));
+        if (it != known.end()) {
+          byte(KNOWN);
+          string(it->second, strlen(it->second));
+        } else {
+          byte(TABLE);
+        }
+
+        lua_pushnil(L);
+        while (lua_next(L, idx)) {
+          if (capturable(lua_type(L, -2)) && capturable(lua_type(L, -1))) {
+            value(-2);
+            value(-1);
+          }
+          lua_pop(L, 1);
+        }
+        byte(END);
+
+        if (lua_getmetatable(L, idx)) {
+          value(-1);
+          lua_pop(L, 1);
+        } else {
+          byte(NIL);
+        }
+      }
+
+      void value(int idx) {
+        idx = lua_absindex(L, idx);
+        luaL_checkstack(L, 8, "state template too deep");
+
+        switch (lua_type(L, idx)) {
+        case LUA_TBOOLEAN:
+          byte(lua_toboolean(L, idx) ? TRUE : FALSE);
+          return;
+        case LUA_TNUMBER:
+          if (lua_isinteger(L, idx)) {
+            lua_Integer i = lua_tointeger(L, idx);
+            byte(INTEGER);
+            raw(&i, sizeof(i));
+          } else {
+            lua_Number n = lua_tonumber(L, idx);
+            byte(NUMBER);
+            raw(&n, sizeof(n));
+          }
+          return;
+        case LUA_TSTRING: {
+          size_t length;
+          const char *s = lua_tolstring(L, idx, &length);
+          byte(STRING);
+          string(s, length);
+          return;
+        }
+        case LUA_TLIGHTUSERDATA: {
+          uint64_t pointer = (uint64_t)(uintptr_t)lua_touserdata(L, idx);
+          byte(LIGHTUSERDATA);
+          raw(&pointer, sizeof(pointer));
+          return;
+        }
+        case LUA_TTABLE:
+        case LUA_TFUNCTION: {
+          const void *pointer = lua_topointer(L, idx);
+          auto it = ids.find(pointer);
+          if (it != ids.end()) {
+            byte(REF);
+            varint(it->second);
+            return;
+          }
+
+          uint64_t id = next_id++;
+          ids.emplace(pointer, id);
+
+          if (lua_istable(L, idx)) table(idx);
+          else function(idx, id);
+          return;
+        }
+        default:
+          byte(NIL);
+          return;
+        }
+      }
+    };
+
+    struct image_reader {
+      lua_State                      *L;
+      const std::vector<std::string> &prototypes;
+      const uint8_t                  *p;
+      const uint8_t                  *end;
+      int                             objects; // Stack index of the table of objects, by id.
+      lua_Integer                     next_id = 0;
+
+      [[noreturn]] void corrupted() {
+        yumlibcxx_throw(corrupted state template image, syserr_t::INVALID_TYPE);
+      }
+
+      uint8_t byte() {
+        if (p >= end) corrupted();
+        return *p++;
+      }
+
+      void raw(void *data, size_t size) {
+        if ((size_t)(end - p) < size) corrupted();
+        memcpy(data, p, size);
+        p += size;
+      }
+
+      uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+          uint8_t b = byte();
+          v |= (uint64_t)(b & 0x7F) << shift;
+          if (!(b & 0x80)) return v;
+        }
+        corrupted();
+      }
+
+      /** @brief Remembers the object at the top of the stack under the next id. */
+      void learn() {
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, objects, ++next_id);
+      }
+
+      void table(bool known) {
+        if (known) {
+          uint64_t length = varint();
+          if ((uint64_t)(end - p) < length) corrupted();
+          std::string name((const char*)p, length);
+          p += length;
+          if (!push_known(L, name.c_str())) lua_newtable(L); // Missing here: the captured one is rebuilt.
+        } else {
+          lua_newtable(L);
+        }
+
+        learn();
+        int t = lua_gettop(L);
+
+        while (p < end && *p != END) {
+          value();
+          value();
+          if (lua_isnil(L, -2)) lua_pop(L, 2); // NaN and nil keys cannot come from Lua, but guard anyway.
+          else lua_rawset(L, t);
+        }
+        byte(); // END
+
+        value();
+        if (lua_istable(L, -1)) lua_setmetatable(L, t);
+        else lua_pop(L, 1);
+      }
+
+      void function(bool is_c) {
+        uint64_t count;
+        if (is_c) {
+          uint64_t pointer;
+          raw(&pointer, sizeof(pointer));
+          count = varint();
+          if (count > 255) corrupted();
+
+          for (uint64_t n = 0; n < count; n++) lua_pushnil(L);
+          lua_pushcclosure(L, (lua_CFunction)(uintptr_t)pointer, (int)count);
+        } else {
+          uint64_t prototype = varint();
+          if (prototype >= prototypes.size()) corrupted();
+
+          const std::string &code = prototypes[prototype];
+          if (luaL_loadbufferx(L, code.data(), code.size(), "=(state template)", "b") != LUA_OK) corrupted();
+          count = varint();
+        }
+
+        learn();
+        int f = lua_gettop(L);
+
+        for (uint64_t n = 1; n <= count; n++) {
+          if (!is_c && p < end && *p == JOIN) {
+            p++;
+            uint64_t other = varint();
+            int index = (int)varint();
+
+            lua_rawgeti(L, objects, (lua_Integer)other + 1);
+            if (!lua_isfunction(L, -1) || lua_iscfunction(L, -1)) corrupted();
+            lua_upvaluejoin(L, f, (int)n, -1, index);
+            lua_pop(L, 1);
+            continue;
+          }
+
+          value();
+          if (!lua_setupvalue(L, f, (int)n)) lua_pop(L, 1);
+        }
+      }
+
+      void value() {
+        luaL_checkstack(L, 8, "state template too deep");
+
+        switch (byte()) {
+        case NIL:   lua_pushnil(L); return;
+        case FALSE: lua_pushboolean(L, 0); return;
+        case TRUE:  lua_pushboolean(L, 1); return;
+        case INTEGER: {
+          lua_Integer i;
+          raw(&i, sizeof(i));
+          lua_pushinteger(L, i);
+          return;
+        }
+        case NUMBER: {
+          lua_Number n;
+          raw(&n, sizeof(n));
+          lua_pushnumber(L, n);
+          return;
+        }
+        case STRING: {
+          uint64_t length = varint();
+          if ((uint64_t)(end - p) < length) corrupted();
+          lua_pushlstring(L, (const char*)p, length);
+          p += length;
+          return;
+        }
+        case LIGHTUSERDATA: {
+          uint64_t pointer;
+          raw(&pointer, sizeof(pointer));
+          lua_pushlightuserdata(L, (void*)(uintptr_t)pointer);
+          return;
+        }
+        case REF: {
+          uint64_t id = varint();
+          if (id >= (uint64_t)next_id) corrupted();
+          lua_rawgeti(L, objects, (lua_Integer)id + 1);
+          return;
+        }
+        case TABLE:        table(false); return;
+        case KNOWN:        table(true); return;
+        case LUA_FUNCTION: function(false); return;
+        case C_FUNCTION:   function(true); return;
+        default:           corrupted();
+        }
+      }
+    };
+  }
+
+  std::shared_ptr<const StateTemplate> StateTemplate::capture(State &state) {
+    YUM_DEBUG_HERE
+    lua_State *L = state.L;
+    int top = lua_gettop(L);
+
+    std::shared_ptr<StateTemplate> result = std::make_shared<StateTemplate>();
+    result->callbacks      = state.callbacks;
+    result->callback_names = state.callback_names;
+    result->free_callbacks = state.free_callbacks;
+    result->archives       = state.archives;
+    result->chunk_cache    = state.chunk_cache;
+    result->large_pages    = state.large_pages;
+    result->stdlibs        = state.stdlibs;
+
+    image_writer writer{ .L = L, .out = result->image, .prototypes = result->prototypes };
+    writer.learn_known();
+
+    lua_pushglobaltable(L);
+    writer.value(-1);
+    if (push_known(L, LUA_LOADED_TABLE)) writer.value(-1);
+    else writer.byte(NIL);
+
+    lua_settop(L, top);
+    result->image.shrink_to_fit();
+
+    YUM_DEBUG_OUTF
+    return result;
+  }
+
+  void StateTemplate::restore(State &state) const {
+    YUM_DEBUG_HERE
+    lua_State *L = state.L;
+
+    state.callbacks      = callbacks;
+    state.callback_names = callback_names;
+    state.free_callbacks = free_callbacks;
+    state.archives       = archives;
+    state.chunk_cache    = chunk_cache;
+    state.large_pages    = large_pages;
+
+    if (stdlibs) state.open_stdlibs();
+
+    int top = lua_gettop(L);
+    lua_createtable(L, 0, 0);
+
+    image_reader reader{
+      .L          = L,
+      .prototypes = prototypes,
+      .p          = (const uint8_t*)image.data(),
+      .end        = (const uint8_t*)image.data() + image.size(),
+      .objects    = lua_gettop(L),
+    };
+
+    try {
+      reader.value(); // Globals.
+      reader.value(); // Loaded modules.
+    } catch (...) {
+      lua_settop(L, top);
+      throw;
+    }
+
+    lua_settop(L, top);
+    YUM_DEBUG_OUTF
+  }
+
+  uint64_t StateTemplate::size() const {
+    uint64_t total = image.size();
+    for (const std::string &prototype : prototypes) total += prototype.size();
+    return total;
+  }
+
+  std::shared_ptr<const StateTemplate> State::capture() {
+    busy_scope busy(this);
+    return StateTemplate::capture(*this);
+  }
+
+  State::State(const StateTemplate &source)
+    : State() {
+    source.restore(*this);
+  }
+
+  State::State(const StateTemplate &source, const allocpolicy_t &policy)
+    : State(policy) {
+    source.restore(*this);
+  }
+}
@@ -0,0 +1,68 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/debug/tracer.hpp"
+#include "inc/types/system/err.h"
+#include "inc/types/system/exception.hpp"
+#include "inc/utils/ystringutils.hpp"
+
+#include <exception>
+
+using namespace YumEngine::xV1;
+
+yumlibcxx_c_header_decoration_begin
+
+/* `categories` is a mask of tracecat_t. 0 stops tracing. */
+void yumlibc_library_member(trace_enable)(uint32_t categories) {
+  Tracer::enable(categories);
+}
+
+uint32_t yumlibc_library_member(trace_categories)(void) {
+  return Tracer::categories();
+}
+
+syserr_t yumlibc_library_member(trace_write_chrome)(utf8 path) {
+  if (!path) return yummakeerror("(utf8)path is null", syserr_t::NULL_OR_EMPTY_ARGUMENT);
+
+  try {
+    if (!Tracer::write_chrome_json(path)) return yummakeerror_runtime("Could not write the trace file", syserr_t::ERROR);
+  } catch (const std::exception &e) {
+    return yumlibcxx_promote_this_exception(e);
+  }
+
+  return yumsuccess;
+}
+
+/* The returned lstring owns its characters: free them with yumfree(). */
+lstring_t yumlibc_library_member(trace_chrome_json)(void) {
+  try {
+    return cxxstring2lstring(Tracer::chrome_json());
+  } catch (const std::exception &) {
+    return lstring_t{ .start = nullptr, .length = 0, .owns = false };
+  }
+}
+
+void yumlibc_library_member(trace_clear)(void) {
+  Tracer::clear();
+}
+
+yumlibcxx_c_header_decoration_end
@@ -0,0 +1,243 @@
+/*************************************************************************************
+ *                                                                                   *
+ *               __   __               _____             _                           *
+ *               \ \ / /   _ _ __ ___ | ____|_ __   __ _(_)_ __   ___                *
+ *                \ V / | | | '_ ` _ \|  _| | '_ \ / _` | | '_ \ / _ \               *
+ *                 | || |_| | | | | | | |___| | | | (_| | | | | |  __/               *
+ *                 |_| \__,_|_| |_| |_|_____|_| |_|\__, |_|_| |_|\___|               *
+ *                                                 |___/                             *
+ *                                                                                   *
+ *                                   By YumStudio                                    *
+ *                                  Lead by モノエ.                                   * 
+ *                                                                                   *
+ *                                All rights reserved                                *
+ *                            This file is free & open source,                       *
+ *                             And covered by the MIT license                        *
+ *                                                                                   *
+ *                        https://github.com/YumStudioHQ/YumEngine                   *
+ *                             https://github.com/YumStudioHQ                        *
+ *                              https://github.com/wys-prog                          *
+ *                                                                                   *
+ *************************************************************************************/
+
+#include "inc/debug/tracer.hpp"
+
+#include <bit>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <utility>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+namespace YumEngine::xV1 {
+  namespace {
+    /** @brief Events of one thread. Only that thread writes `events` and `head`. */
+    struct ring {
+      uint32_t                         tid;
+      std::atomic<uint64_t>            head{0}; // Events written since the ring was created.
+      std::atomic<uint64_t>            tail{0}; // First event not cleared.
+      std::unique_ptr<Tracer::event[]> events;
+    };
+
+    struct registry {
+      std::mutex                         lock;
+      std::vector<std::unique_ptr<ring>> rings;
+      std::vector<ring*>                 idle;        // Rings of threads that exited, for the next ones.
+      uint32_t                           threads = 0; // Threads that traced so far, numbering them.
+    };
+
+    // Never destroyed: threads may still trace while static objects are.
+    registry &rings() {
+      static registry *instance = new registry();
+      return *instance;
+    }
+
+    /** @brief Gives the ring of an exiting thread back. Its events stay exported until another thread takes it. */
+    struct ring_owner {
+      ring *own = nullptr;
+
+      ~ring_owner() {
+        if (!own) return;
+
+        registry &all = rings();
+        std::lock_guard<std::mutex> guard(all.lock);
+        all.idle.push_back(std::exchange(own, nullptr));
+      }
+    };
+
+    ring &local() {
+      thread_local ring_owner owner;
+      if (owner.own) return *owner.own;
+
+      registry &all = rings();
+      std::lock_guard<std::mutex> guard(all.lock);
+
+      ring *own;
+      if (!all.idle.empty()) {
+        own = all.idle.back();
+        all.idle.pop_back();
+        own->tail.store(own->head.load(std::memory_order_relaxed), std::memory_order_relaxed); // Drops the previous thread's events.
+      } else {
+        all.rings.push_back(std::make_unique<ring>());
+        own = all.rings.back().get();
+        own->events = std::make_unique<Tracer::event[]>(Tracer::ring_capacity);
+      }
+
+      own->tid = ++all.threads;
+      owner.own = own;
+      return *own;
+    }
+
+    const char *const category_names[] = { "calls", "callbacks", "gc", "tasks", "loads", "debug" };
+
+    void append_escaped(std::string &out, const char *text, size_t length) {
+      for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '"' || c == '\\') {
+          out += '\\';
+          out += (char)c;
+        } else if (c < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out += escaped;
+        } else out += (char)c;
+      }
+    }
+  }
+
+#ifdef DEBUG
+  std::atomic<uint32_t> Tracer::mask = YUM_TRACE_DEBUG;
+#else
+  std::atomic<uint32_t> Tracer::mask = 0;
+#endif
+
+  void Tracer::enable(uint32_t categories) {
+    mask.store(categories & YUM_TRACE_ALL, std::memory_order_relaxed);
+  }
+
+  uint32_t Tracer::categories() {
+    return mask.load(std::memory_order_relaxed);
+  }
+
+  uint64_t Tracer::now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void Tracer::push(uint32_t category, char phase, const char *name, uint64_t ts_ns, uint64_t dur_ns, std::string_view detail, uint64_t value) {
+    ring &own = local();
+    uint64_t head = own.head.load(std::memory_order_relaxed);
+    event &e = own.events[head & (ring_capacity - 1)];
+
+    // Truncated details are cut on a character boundary, for the export to stay valid UTF-8.
+    size_t length = std::min(detail.size(), sizeof(e.detail));
+    if (length < detail.size()) {
+      while (length > 0 && ((unsigned char)detail[length] & 0xC0) == 0x80) length--;
+    }
+
+    e.ts_ns = ts_ns;
+    e.dur_ns = dur_ns;
+    e.value = value;
+    e.name = name;
+    e.category = (uint8_t)std::countr_zero(category);
+    e.phase = phase;
+    e.detail_length = (uint8_t)length;
+    std::memcpy(e.detail, detail.data(), length);
+
+    own.head.store(head + 1, std::memory_order_release);
+  }
+
+  void Tracer::complete(uint32_t category, const char *name, uint64_t start_ns, std::string_view detail, uint64_t value) {
+    uint64_t end = now();
+    push(category, 'X', name, start_ns, end > start_ns ? end - start_ns : 0, detail, value);
+  }
+
+  void Tracer::instant(uint32_t category, const char *name, std::string_view detail, uint64_t value) {
+    push(category, 'i', name, now(), 0, detail, value);
+  }
+
+  void Tracer::counter(uint32_t category, const char *name, uint64_t value) {
+    push(category, 'C', name, now(), 0, {}, value);
+  }
+
+  std::string Tracer::chrome_json() {
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first_event = true;
+
+    registry &all = rings();
+    std::lock_guard<std::mutex> guard(all.lock);
+
+    std::vector<event> copied;
+    for (const auto &own : all.rings) {
+      uint64_t head = own->head.load(std::memory_order_acquire);
+      uint64_t first = std::max(own->tail.load(std::memory_order_relaxed), head > ring_capacity ? head - ring_capacity : 0);
+
+      copied.clear();
+      for (uint64_t i = first; i < head; i++) copied.push_back(own->events[i & (ring_capacity - 1)]);
+
+      // The thread kept writing: events whose slot it reached since may be torn. The slot of `after` is being written.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint64_t after = own->head.load(std::memory_order_relaxed);
+      uint64_t valid = after >= ring_capacity ? after - ring_capacity + 1 : 0;
+      uint64_t skip = valid > first ? std::min<uint64_t>(valid - first, copied.size()) : 0;
+
+      for (uint64_t i = skip; i < copied.size(); i++) {
+        const event &e = copied[i];
+        char numbers[160];
+
+        if (!first_event) out += ',';
+        first_event = false;
+
+        out += "{\"name\":\"";
+        append_escaped(out, e.name, std::strlen(e.name));
+        out += "\",\"cat\":\"";
+        out += e.category < std::size(category_names) ? category_names[e.category] : "other";
+        out += "\",\"ph\":\"";
+        out += e.phase;
+
+        std::snprintf(numbers, sizeof(numbers), "\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", own->tid, (double)e.ts_ns / 1000.0);
+        out += numbers;
+
+        if (e.phase == 'X') {
+          std::snprintf(numbers, sizeof(numbers), ",\"dur\":%.3f", (double)e.dur_ns / 1000.0);
+          out += numbers;
+        } else if (e.phase == 'i') out += ",\"s\":\"t\"";
+
+        std::snprintf(numbers, sizeof(numbers), ",\"args\":{\"value\":%llu", (unsigned long long)e.value);
+        out += numbers;
+
+        if (e.detail_length) {
+          out += ",\"detail\":\"";
+          append_escaped(out, e.detail, e.detail_length);
+          out += '"';
+        }
+
+        out += "}}";
+      }
+    }
+
+    out += "]}";
+    return out;
+  }
+
+  bool Tracer::write_chrome_json(utf8 path) {
+    if (!path) return false;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    std::string json = chrome_json();
+    file.write(json.data(), (std::streamsize)json.size());
+    return file.good();
+  }
+
+  void Tracer::clear() {
+    registry &all = rings();
+    std::lock_guard<std::mutex> guard(all.lock);
+
+    for (const auto &own : all.rings) own->tail.store(own->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
@@ -21,6 +21,7 @@
  *************************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "inc/types/base/types.h"
 #include "inc/types/base/vardef.h"
@@ -62,11 +63,19 @@ yumlibc_vdllmember void yumfree_lstring(lstring_t lstring) {
   free_lstring(lstring);
 }
 
+yumlibc_vdllmember void yumfree_table(vartable_t *table) {
+  // Nested tables, strings and binaries live in the same block.
+  if (table && table->owns) yumfree((void*)table);
+}
+
 yumlibc_vdllmember void yumfree_all(variant_t *vars, uint64_t length) {
   for (uint64_t i = 0; i < length; i++) {
     variant_t var = vars[i];
     if (var.type == VARIANT_STRING) yumfree_lstring(var.hold.lstring);
     else if (var.type == VARIANT_BINARY) free_binary(var.hold.binary);
+    else if (var.type == VARIANT_TABLE) yumfree_table(var.hold.table);
+    else if (var.type == VARIANT_INTEGER_ARRAY && var.hold.integers.owns) yumfree((void*)var.hold.integers.start);
+    else if (var.type == VARIANT_NUMBER_ARRAY && var.hold.numbers.owns) yumfree((void*)var.hold.numbers.start);
   }
 }
 
@@ -77,6 +86,6 @@ yumlibc_vdllmember void yumfree_array(variant_t *vars, uint64_t length) {
 
 yumlibc_vdllmember char *yumstrcpy(const char *src, uint64_t len) {
   char *buff = (char*)yumalloc(sizeof(char) * len);
-  for (uint64_t i = 0; i < len; i++) buff[i] = src[i];
+  if (len > 0) memcpy(buff, src, len);
   return buff;
 }
\ No newline at end of file
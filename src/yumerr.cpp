@@ -50,6 +50,10 @@ yumlibc_cfun const char *category_to_ascii(syserr_t err) {
     case err.ILL_FUNCTION_PATH: return "ill function path";
     case err.PROMOTED_CXX_EXCEPTION: return "promoted C++ exception";
     case err.SDK_EXCEPTION: return "SDK exception";
+    case err.INVALID_HANDLE: return "invalid handle";
+    case err.BUFFER_OVERFLOW: return "buffer overflow";
+    case err.OUT_OF_MEMORY: return "out of memory";
+    case err.BUDGET_EXCEEDED: return "budget exceeded";
     default: _mstr += std::to_string((int)err.category);
              return _mstr.c_str();
   }
@@ -54,6 +54,15 @@ extern "C" {
       case variant_t::VARIANT_BINARY:
         mbuff = std::string((char*)var.hold.binary.start, var.hold.binary.length);
         break;
+      case variant_t::VARIANT_TABLE:
+        mbuff = "<table>";
+        break;
+      case variant_t::VARIANT_INTEGER_ARRAY:
+        mbuff = "<integer[" + std::to_string(var.hold.integers.length) + "]>";
+        break;
+      case variant_t::VARIANT_NUMBER_ARRAY:
+        mbuff = "<number[" + std::to_string(var.hold.numbers.length) + "]>";
+        break;
       default: break;
     }
 
@@ -57,6 +57,13 @@ OUTPUT_DIR_RELEASE = "bin/release"
 OUTPUT_DIR_DEBUG   = "bin/debug"
 TMP = "temp"
 
+# Benchmarks: host executables, one per bench/*.cpp, never part of the library.
+BENCH_DIR        = "bench"
+OUTPUT_DIR_BENCH = "bin/bench"
+FLAGS_CC_BENCH   = "-std=c17 -Wall -Wextra -O2 -c -I./ -I../ -I./inc/ -I./inc/lua"
+FLAGS_CXX_BENCH  = "-std=c++23 -Wall -Wextra -O2 -c -I./ -I../ -I./inc/ -I./inc/lua"
+LUA_MAINS        = ["lua.c", "luac.c", "onelua.c"]
+
 LINK_FLAGS_MACOS   = "-dynamiclib"
 LINK_FLAGS_WINDOWS = "-shared -static -static-libstdc++ -static-libgcc"
 LINK_FLAGS_LINUX   = "-shared"
@@ -103,6 +110,7 @@ def find_files(ext: str) -> List[str]:
     for root, _dirs, files in os.walk("."):
         for f in files:
             if f.endswith(ext) and not "docs/" in root: # exclude docs folder... This is dirty but should work lol.
+                if os.path.normpath(root).split(os.sep)[0] == BENCH_DIR: continue
                 out.append(os.path.join(root, f))
     return out
 
@@ -196,6 +204,30 @@ def build_all(flags_c: str, flags_cpp: str, output_dir: str):
     success("ALL BUILDS COMPLETED SUCCESSFULLY.\n")
 
 
+def build_bench():
+    shutil.rmtree(OUTPUT_DIR_BENCH, ignore_errors=True)
+    shutil.rmtree(TMP, ignore_errors=True)
+    os.makedirs(OUTPUT_DIR_BENCH)
+    os.makedirs(TMP)
+
+    header("Benchmarks (host)")
+
+    cfiles = [f for f in find_files(".c") if os.path.basename(f) not in LUA_MAINS]
+    objs = compile_files(cfiles, "gcc", FLAGS_CC_BENCH) + compile_files(find_files(".cpp"), "g++", FLAGS_CXX_BENCH)
+
+    mains = sorted(os.path.join(BENCH_DIR, f) for f in os.listdir(BENCH_DIR) if f.endswith(".cpp"))
+    for main in mains:
+        obj = compile_files([main], "g++", FLAGS_CXX_BENCH)[0]
+        out = os.path.join(OUTPUT_DIR_BENCH, os.path.splitext(os.path.basename(main))[0])
+        objlist = " ".join(f'"{o}"' for o in objs + [obj])
+
+        if not run(f'g++ {objlist} -o "{out}" -lpthread'):
+            fail(f"Link failed: {out}")
+            sys.exit(1)
+
+        success(f"Built → {GREEN}{out}{RESET}")
+
+
 # ──────────────────────────────────────────────────────────────
 # ZIP PACKAGING (from script #1, rewritten with UI)
 # ──────────────────────────────────────────────────────────────
@@ -290,6 +322,8 @@ def main():
         package_outputs(OUTPUT_DIR_DEBUG, OUTPUT_DIR_RELEASE)
 
         success("DONE.\n")
+    elif "--bench" in sys.argv:
+        build_bench()
     else:
         build_all(FLAGS_CC_DEBUG, FLAGS_CXX_DEBUG, OUTPUT_DIR_DEBUG)
 